@@ -0,0 +1,259 @@
+#include "InputSearch.h"
+
+#include "InstanceUtils.h"
+
+#include "Core/Core.h"
+#include "Core/State.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+    constexpr unsigned char STICK_CENTER = 128;
+
+    DolphinControllerState MakeNeutralState()
+    {
+        DolphinControllerState state;
+        state.AnalogStickX = STICK_CENTER;
+        state.AnalogStickY = STICK_CENTER;
+        state.CStickX = STICK_CENTER;
+        state.CStickY = STICK_CENTER;
+        state.IsConnected = true;
+        return state;
+    }
+}
+
+std::vector<DolphinControllerState> InputSearch::ExpandChoices(const DolphinSearchFrame& frame)
+{
+    std::vector<DolphinControllerState> buttonChoices = frame.ButtonChoices;
+
+    if (buttonChoices.empty())
+    {
+        buttonChoices.push_back(MakeNeutralState());
+    }
+
+    if (frame.StickSectors <= 0)
+    {
+        return buttonChoices;
+    }
+
+    std::vector<DolphinControllerState> choices;
+    choices.reserve(buttonChoices.size() * (size_t(frame.StickSectors) + (frame.IncludeStickNeutral ? 1 : 0)));
+
+    for (const DolphinControllerState& buttonChoice : buttonChoices)
+    {
+        if (frame.IncludeStickNeutral)
+        {
+            DolphinControllerState choice = buttonChoice;
+            choice.AnalogStickX = STICK_CENTER;
+            choice.AnalogStickY = STICK_CENTER;
+            choices.push_back(choice);
+        }
+
+        for (int sector = 0; sector < frame.StickSectors; sector++)
+        {
+            const double angle = 2.0 * 3.14159265358979323846 * sector / frame.StickSectors;
+
+            DolphinControllerState choice = buttonChoice;
+            choice.AnalogStickX = u8(std::clamp(int(std::lround(STICK_CENTER + frame.StickMagnitude * std::cos(angle))), 0, 255));
+            choice.AnalogStickY = u8(std::clamp(int(std::lround(STICK_CENTER + frame.StickMagnitude * std::sin(angle))), 0, 255));
+            choices.push_back(choice);
+        }
+    }
+
+    return choices;
+}
+
+bool InputSearch::Begin(int controllerId, const std::vector<DolphinSearchFrame>& frames, int horizonFrames, const std::vector<DolphinSearchObjectiveTerm>& objective, int topK, u64 maxCandidates)
+{
+    if (IsActive() || controllerId < 0 || controllerId > LAST_CONTROLLER || horizonFrames <= 0 || topK <= 0 || objective.empty())
+    {
+        return false;
+    }
+
+    _controllerId = controllerId;
+    _horizonFrames = horizonFrames;
+    _topK = size_t(topK);
+    _objective = objective;
+    _frameChoices.clear();
+    _framePadStatuses.clear();
+
+    // Frames past the horizon can never be played, so they do not multiply the space
+    _candidateCount = 1;
+
+    for (size_t frameIndex = 0; frameIndex < frames.size() && frameIndex < size_t(horizonFrames); frameIndex++)
+    {
+        std::vector<DolphinControllerState> choices = ExpandChoices(frames[frameIndex]);
+        std::vector<GCPadStatus> padStatuses(choices.size());
+
+        for (size_t choiceIndex = 0; choiceIndex < choices.size(); choiceIndex++)
+        {
+            InstanceUtils::CopyControllerStateToGcPadStatus(choices[choiceIndex], &padStatuses[choiceIndex]);
+        }
+
+        const u64 choiceCount = u64(choices.size());
+        _candidateCount = _candidateCount > std::numeric_limits<u64>::max() / choiceCount ? std::numeric_limits<u64>::max() : _candidateCount * choiceCount;
+
+        _frameChoices.push_back(std::move(choices));
+        _framePadStatuses.push_back(std::move(padStatuses));
+    }
+
+    if (maxCandidates > 0)
+    {
+        _candidateCount = std::min(_candidateCount, maxCandidates);
+    }
+
+    Core::RunAsCPUThread([&]
+    {
+        State::SaveToBuffer(_rootState);
+    });
+
+    if (_rootState.empty())
+    {
+        return false;
+    }
+
+    _best.clear();
+    _candidatesEvaluated = 0;
+    _startTime = std::chrono::steady_clock::now();
+    SelectCandidate(0);
+
+    _isActive.store(true, std::memory_order_release);
+
+    return true;
+}
+
+void InputSearch::SelectCandidate(u64 candidate)
+{
+    _currentCandidate = candidate;
+    _currentChoices.resize(_frameChoices.size());
+
+    // Mixed radix, with the first frame as the fastest changing digit
+    for (size_t frameIndex = 0; frameIndex < _frameChoices.size(); frameIndex++)
+    {
+        const u64 choiceCount = u64(_frameChoices[frameIndex].size());
+        _currentChoices[frameIndex] = size_t(candidate % choiceCount);
+        candidate /= choiceCount;
+    }
+
+    _pollInCandidate = 0;
+    _isScored = false;
+}
+
+bool InputSearch::ApplyInput(int controllerId, GCPadStatus& outPadStatus)
+{
+    // Inputs polled after scoring, before the CPU actually stops, belong to no candidate
+    if (_isScored)
+    {
+        return false;
+    }
+
+    if (controllerId == 0 && _pollInCandidate >= _horizonFrames)
+    {
+        ScoredCandidate scored;
+        scored._score = Score();
+        scored._candidate = _currentCandidate;
+
+        if (_best.size() < _topK)
+        {
+            _best.push_back(scored);
+            std::push_heap(_best.begin(), _best.end());
+        }
+        else if (scored._score > _best.front()._score)
+        {
+            std::pop_heap(_best.begin(), _best.end());
+            _best.back() = scored;
+            std::push_heap(_best.begin(), _best.end());
+        }
+
+        _candidatesEvaluated++;
+        _isScored = true;
+
+        return true;
+    }
+
+    if (controllerId == _controllerId && !_framePadStatuses.empty())
+    {
+        const size_t frameIndex = std::min(size_t(_pollInCandidate), _framePadStatuses.size() - 1);
+        outPadStatus = _framePadStatuses[frameIndex][_currentChoices[frameIndex]];
+    }
+
+    if (controllerId == LAST_CONTROLLER)
+    {
+        _pollInCandidate++;
+    }
+
+    return false;
+}
+
+double InputSearch::Score() const
+{
+    double score = 0.0;
+
+    for (const DolphinSearchObjectiveTerm& term : _objective)
+    {
+        double value = 0.0;
+
+        if (InstanceUtils::ReadValue(InstanceUtils::ResolvePointer(term.Address, term.PointerOffsets), term.ValueType, value))
+        {
+            score += term.Weight * value;
+        }
+    }
+
+    return score;
+}
+
+bool InputSearch::NextCandidate()
+{
+    const bool hasNext = _currentCandidate + 1 < _candidateCount;
+
+    if (hasNext)
+    {
+        SelectCandidate(_currentCandidate + 1);
+    }
+
+    // The CPU is stopped between candidates, so this runs without pausing anything
+    State::LoadFromBuffer(_rootState);
+
+    if (!hasNext)
+    {
+        _isActive.store(false, std::memory_order_release);
+    }
+
+    return hasNext;
+}
+
+std::vector<DolphinSearchResult> InputSearch::TakeResults(u64& outCandidatesEvaluated, float& outCandidatesPerSecond)
+{
+    std::sort_heap(_best.begin(), _best.end());
+
+    std::vector<DolphinSearchResult> results;
+    results.reserve(_best.size());
+
+    for (const ScoredCandidate& scored : _best)
+    {
+        SelectCandidate(scored._candidate);
+
+        DolphinSearchResult result;
+        result.Score = scored._score;
+
+        for (int frame = 0; frame < _horizonFrames && !_frameChoices.empty(); frame++)
+        {
+            const size_t frameIndex = std::min(size_t(frame), _frameChoices.size() - 1);
+            result.Inputs.push_back(_frameChoices[frameIndex][_currentChoices[frameIndex]]);
+        }
+
+        results.push_back(std::move(result));
+    }
+
+    const double elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - _startTime).count();
+    outCandidatesEvaluated = _candidatesEvaluated;
+    outCandidatesPerSecond = elapsedSeconds > 0.0 ? float(_candidatesEvaluated / elapsedSeconds) : 0.0f;
+
+    _best.clear();
+    std::vector<u8>().swap(_rootState);
+
+    return results;
+}
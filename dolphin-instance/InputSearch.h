@@ -0,0 +1,64 @@
+#pragma once
+
+#include "dolphin-ipc/IpcStructs.h"
+
+#include "Common/CommonTypes.h"
+#include "InputCommon/GCPadStatus.h"
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+// Brute forces a short input window from a root state without leaving the instance. Each candidate reloads the root from
+// memory, plays its inputs for the horizon and is scored from RAM, and only the best k are kept.
+// The CPU thread and the host thread take turns: the host only touches the search while the CPU is stopped between candidates.
+class InputSearch
+{
+public:
+	// Host thread. Captures the current state as the root every candidate starts from.
+	bool Begin(int controllerId, const std::vector<DolphinSearchFrame>& frames, int horizonFrames, const std::vector<DolphinSearchObjectiveTerm>& objective, int topK, u64 maxCandidates);
+	bool IsActive() const { return _isActive.load(std::memory_order_acquire); }
+
+	// CPU thread, for every controller poll while active. Returns true once the current candidate has been scored.
+	bool ApplyInput(int controllerId, GCPadStatus& outPadStatus);
+
+	// Host thread, after ApplyInput returned true. Loads the root for the next candidate, or restores it and returns false
+	// once the search is finished.
+	bool NextCandidate();
+	std::vector<DolphinSearchResult> TakeResults(u64& outCandidatesEvaluated, float& outCandidatesPerSecond);
+
+	static std::vector<DolphinControllerState> ExpandChoices(const DolphinSearchFrame& frame);
+
+private:
+	static constexpr int LAST_CONTROLLER = 3;
+
+	struct ScoredCandidate
+	{
+		double _score = 0.0;
+		u64 _candidate = 0;
+
+		// Inverted, so the heap keeps the worst of the best k on top
+		bool operator<(const ScoredCandidate& other) const { return _score > other._score; }
+	};
+
+	void SelectCandidate(u64 candidate);
+	double Score() const;
+
+	std::atomic<bool> _isActive = false;
+	bool _isScored = false;
+	int _controllerId = 0;
+	int _horizonFrames = 1;
+	int _pollInCandidate = 0;
+	size_t _topK = 10;
+	u64 _candidateCount = 0;
+	u64 _currentCandidate = 0;
+	u64 _candidatesEvaluated = 0;
+	std::chrono::steady_clock::time_point _startTime;
+
+	std::vector<std::vector<DolphinControllerState>> _frameChoices;
+	std::vector<std::vector<GCPadStatus>> _framePadStatuses;	// _frameChoices converted once up front
+	std::vector<size_t> _currentChoices;						// Choice index per branching frame
+	std::vector<DolphinSearchObjectiveTerm> _objective;
+	std::vector<ScoredCandidate> _best;
+	std::vector<u8> _rootState;
+};
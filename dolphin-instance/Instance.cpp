@@ -10,6 +10,7 @@
 
 // Dolphin includes
 #include "Common/FileUtil.h"
+#include "Core/Config/GraphicsSettings.h"
 #include "Core/Config/MainSettings.h"
 #include "Core/Config/WiimoteSettings.h"
 #include "Core/ConfigManager.h"
@@ -39,8 +40,14 @@
 #include "InputCommon/InputConfig.h"
 #include "VideoCommon/VideoConfig.h"
 
+#include <algorithm>
+#include <thread>
+
 #pragma optimize("", off)
 
+// The step mode park also watches for shutdown and for the CPU leaving the running state, neither of which notify it
+static const auto StepParkPollInterval = std::chrono::milliseconds(1);
+
 Instance::Instance(const InstanceBootParameters& bootParams)
 {
     InitializeLaunchOptions(bootParams);
@@ -51,11 +58,16 @@ Instance::Instance(const InstanceBootParameters& bootParams)
 
 Instance::~Instance()
 {
+    // Card changes are written through as they are made, this only retries any write that failed
+    _saveStateWriter.WaitForIdle();
+    InstanceUtils::FlushMemoryCards();
 }
 
 void Instance::InitializeLaunchOptions(const InstanceBootParameters& bootParams)
 {
     bool recordOnLaunch = bootParams.recordOnLaunch;
+    _instanceId = bootParams.instanceId;
+    _saveStateStore.SetWriterTag(_instanceId);
 
     // For debugging some parts of IPC locally
     if (bootParams.instanceId == "MOCK")
@@ -180,6 +192,67 @@ void Instance::PrepareForTASInput()
             Log(Common::Log::LogLevel::LERROR, "Unexpected controller id");
         }
 
+        // Frames that go by without any poll are lag frames, so this runs ahead of everything that might skip the rest
+        if (controllerId == FIRST_CONTROLLER)
+        {
+            _isFirstPollOfFrame = _lagFrameTracker.OnInputPolled(Movie::GetCurrentFrame());
+        }
+
+        // A rewind replays recorded inputs, bypassing everything else until the target frame is reached
+        if (_rewindBuffer.IsReplaying())
+        {
+            if (_rewindBuffer.ReplayInput(controllerId, *padStatus))
+            {
+                CPU::Break();
+                Core::QueueHostJob([=]
+                {
+                    Config::SetCurrent(Config::MAIN_EMULATION_SPEED, _rewindPreviousEmulationSpeed);
+                    RefreshSharedRam();
+                    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_RewindToFrame);
+                });
+            }
+            return;
+        }
+
+        // An input search plays its own candidates from the root state until it finishes
+        if (_inputSearch.IsActive())
+        {
+            if (_inputSearch.ApplyInput(controllerId, *padStatus))
+            {
+                CPU::Break();
+                Core::QueueHostJob([=]
+                {
+                    AdvanceInputSearch();
+                });
+            }
+            return;
+        }
+
+        // Scheduled calls run before step mode parks, so they land on the frame they were scheduled for
+        if (controllerId == FIRST_CONTROLLER)
+        {
+            RunScheduledCommands();
+        }
+
+        // Step mode parks before any controller of the frame is polled, so inputs set while parked apply to the whole frame
+        if (controllerId == FIRST_CONTROLLER && _isStepModeEnabled)
+        {
+            WaitForStepToken();
+        }
+
+        // Queued TAS inputs stand in for the hardware controller in every state but playback, and get recorded like it
+        if (_instanceState != RecordingState::Playback && _tasInputQueue.IsActive(controllerId))
+        {
+            _tasInputQueue.Pop(controllerId, _tasInputStates[controllerId]);
+            InstanceUtils::CopyControllerStateToGcPadStatus(_tasInputStates[controllerId], padStatus);
+            _hardwareInputStates[controllerId] = _tasInputStates[controllerId];
+        }
+
+        if (controllerId == LAST_CONTROLLER && _tasInputQueue.TakeLowWater())
+        {
+            SendTasInputQueueStatus(true, nullptr);
+        }
+
         // Record or playback
         switch (_instanceState)
         {
@@ -188,12 +261,17 @@ void Instance::PrepareForTASInput()
                 if (controllerId == LAST_CONTROLLER)
                 {
                     CheckGcFrameAdvance(padStatus, controllerId, false);
+
+                    if (!VerifyPlaybackRamHash())
+                    {
+                        break;
+                    }
                 }
 
                 if (!_playbackInputs[controllerId].HasNext())
                 {
                     // Log(Common::Log::LogLevel::LERROR, "Unexpected end of playback input");
-                    return;
+                    break;
                 }
 
                 DolphinControllerState padState = _playbackInputs[controllerId].PopNext();
@@ -251,8 +329,13 @@ void Instance::PrepareForTASInput()
                 {
                     Core::QueueHostJob([=]
                     {
-                        Core::SetState(Core::State::Paused);
-                        OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_PlayInputs);
+                        // Step mode holds the CPU in its park already, pausing it here would end the park
+                        if (!_isStepModeEnabled)
+                        {
+                            Core::SetState(Core::State::Paused);
+                        }
+
+                        OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_PlayInputs, EndTimedRun());
                     });
                     _instanceState = RecordingState::None;
                 }
@@ -263,6 +346,7 @@ void Instance::PrepareForTASInput()
                 if (controllerId == LAST_CONTROLLER)
                 {
                     CheckGcFrameAdvance(padStatus, controllerId, false);
+                    _ramHashChecker.RecordPoll();
                 }
 
                 if (_isRecordingController[controllerId])
@@ -274,6 +358,11 @@ void Instance::PrepareForTASInput()
             case RecordingState::None:
             default:
             {
+                if (_isStepModeEnabled && (!_shouldUseHardwareController || _isStepUsingTasInput))
+                {
+                    InstanceUtils::CopyControllerStateToGcPadStatus(_tasInputStates[controllerId], padStatus);
+                }
+
                 if (controllerId == LAST_CONTROLLER)
                 {
                     CheckGcFrameAdvance(padStatus, controllerId, false);
@@ -281,262 +370,1435 @@ void Instance::PrepareForTASInput()
                 break;
             }
         }
-    });
-}
-
-void Instance::CheckGcFrameAdvance(GCPadStatus* padStatus, int controllerId, bool checkInputs)
-{
-    // Perform frame advance
-    if (_framesToAdvance > 0)
-    {
-        if (checkInputs && !_shouldUseHardwareController)
-        {
-            // Replace hardware input with TAS input
-            InstanceUtils::CopyControllerStateToGcPadStatus(_tasInputStates[controllerId], padStatus);
-        }
 
-        if (--_framesToAdvance <= 0)
+        if (_rewindBuffer.IsEnabled() && _rewindBuffer.RecordInput(controllerId, *padStatus, Movie::GetCurrentFrame()))
         {
             Core::QueueHostJob([=]
             {
-                Core::SetState(Core::State::Paused);
-                OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_FrameAdvance);
+                // A step mode park must not be ended by the capture, so it goes through the parked CPU thread if there is one
+                _rewindBuffer.CaptureCheckpoint([this](const std::function<void()>& job)
+                {
+                    RunWithCpuPaused(job);
+                });
             });
         }
-    }
-
-    // Update stored input states, which will be applied to the game and potentially recordings (either from TAS input or hardware controller)
-    if (checkInputs)
-    {
-        InstanceUtils::CopyGcPadStatusToControllerState(padStatus, _hardwareInputStates[controllerId]);
-    }
+    });
 }
 
-INSTANCE_FUNC_BODY(Instance, Connect, params)
+void Instance::AdvanceInputSearch()
 {
-}
+    if (_inputSearch.NextCandidate())
+    {
+        Core::SetState(Core::State::Running);
+        return;
+    }
 
-INSTANCE_FUNC_BODY(Instance, Heartbeat, params)
-{
-    _lastHeartbeat = std::chrono::system_clock::now();
-    _shouldUseHardwareController = params._shouldUseHardwareController;
+    // The root state has been restored, leave emulation paused on it
+    EndTimedRun();
+    RefreshSharedRam();
 
-    // Acknowledge heartbeat, sending over any state data the server may want.
-    CREATE_TO_SERVER_DATA(OnInstanceHeartbeatAcknowledged, ipcData, data)
-    data->_isRecording = _instanceState == RecordingState::Recording;
-    data->_isPaused = Core::GetState() == Core::State::Paused;
-    data->_hardwareInputStates[0] = _hardwareInputStates[0];
-    data->_hardwareInputStates[1] = _hardwareInputStates[1];
-    data->_hardwareInputStates[2] = _hardwareInputStates[2];
-    data->_hardwareInputStates[3] = _hardwareInputStates[3];
+    CREATE_TO_SERVER_DATA(OnInstanceInputSearchCompleted, ipcData, data)
+    data->_results = _inputSearch.TakeResults(data->_candidatesEvaluated, data->_candidatesPerSecond);
     ipcSendToServer(ipcData);
 }
 
-INSTANCE_FUNC_BODY(Instance, Terminate, params)
+void Instance::BeginStep(int numFrames, bool returnObservation)
 {
-    StopRecording();
-    RequestShutdown();
+    _stepReturnsObservation = returnObservation;
+    _stepFramesRemaining = numFrames;
+
+    // A parked CPU thread picks the token up by itself, otherwise it was left in a break that has to be lifted here
+    if (!Core::IsCPUThread())
+    {
+        CPU::EnableStepping(false);
+    }
 }
 
-INSTANCE_FUNC_BODY(Instance, StartRecordingInput, params)
+void Instance::WaitForStepToken()
 {
-    StopRecording();
-    StartRecording();
+    // Runs on the CPU thread. Completing a step is reported from here, with no host job or core state change in between.
+    if (_stepFramesRemaining > 0)
+    {
+        if (--_stepFramesRemaining > 0)
+        {
+            return;
+        }
 
-    _isRecordingController[0] = params._recordControllers[0];
-    _isRecordingController[1] = params._recordControllers[1];
-    _isRecordingController[2] = params._recordControllers[2];
-    _isRecordingController[3] = params._recordControllers[3];
+        _isStepUsingTasInput = false;
 
-    if (params._unpauseInstance)
-    {
-        if (Core::GetState() == Core::State::Paused)
+        if (_stepReturnsObservation)
         {
-            Core::SetState(Core::State::Running);
+            CREATE_TO_SERVER_DATA(OnInstanceStepCompleted, ipcData, data)
+            _stepObserver.Capture(*data);
+            data->_stateHash = _stateHasher.Compute();
+            ipcSendToServer(ipcData);
+        }
+        else
+        {
+            OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_StepFrames);
         }
     }
 
-    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_StartRecordingInput);
-}
+    std::unique_lock<std::mutex> ipcLock(_ipcReceiveMutex);
+    _isStepParked = true;
+    _stepParkCondition.notify_all();
 
-INSTANCE_FUNC_BODY(Instance, StopRecordingInput, params)
-{
-    StopRecording();
-    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_StopRecordingInput);
-}
+    bool shouldBreak = false;
 
-INSTANCE_FUNC_BODY(Instance, PauseEmulation, params)
-{
-    if (Core::GetState() == Core::State::Running)
+    while (true)
     {
-        Core::SetState(Core::State::Paused);
-    }
+        // Host work that needs the CPU paused runs here, since pausing the CPU from the host thread would end the park
+        if (!_parkedCpuJobs.empty())
+        {
+            std::packaged_task<void()> job = std::move(_parkedCpuJobs.front());
+            _parkedCpuJobs.pop();
+            ipcLock.unlock();
+            job();
+            ipcLock.lock();
+            continue;
+        }
 
-    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_PauseEmulation);
-}
+        if (!_isStepModeEnabled || !_running.IsSet() || _stepFramesRemaining > 0)
+        {
+            break;
+        }
 
-INSTANCE_FUNC_BODY(Instance, ResumeEmulation, params)
-{
-    if (Core::GetState() == Core::State::Paused)
+        // Nothing in the instance pauses a parked CPU, so this is a break already requested on this frame (ie by scheduled
+        // calls) or Dolphin stopping. Either way the pause only goes through once this thread leaves the callback.
+        if (CPU::GetState() != CPU::State::Running)
+        {
+            break;
+        }
+
+        if (_parkedServerCalls.empty())
+        {
+            // Shutdown clears _running without a notification, so it is checked for at this interval
+            _stepParkCondition.wait_for(ipcLock, StepParkPollInterval);
+            continue;
+        }
+
+        // Calls that may pause the CPU stay queued for the host thread, which runs them once this thread has stopped
+        if (!CanRunOnCpuThread(_parkedServerCalls.front()._call))
+        {
+            shouldBreak = true;
+            break;
+        }
+
+        DolphinIpcToInstanceData data = std::move(_parkedServerCalls.front());
+        _parkedServerCalls.pop_front();
+        ipcLock.unlock();
+        onServerToInstanceDataReceived(data);
+        ipcLock.lock();
+    }
+
+    // Break while still holding the lock, so the host thread never sees the park end with the CPU still running
+    if (shouldBreak)
     {
-        Core::SetState(Core::State::Running);
+        CPU::Break();
     }
 
-    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_ResumeEmulation);
+    _isStepParked = false;
 }
 
-INSTANCE_FUNC_BODY(Instance, PlayInputs, params)
+// Requires _ipcReceiveMutex. While a step is parked or running, server calls go to the CPU thread rather than the host thread.
+bool Instance::IsStepDispatchOnCpuThread() const
 {
-    // These vectors can be masive, use std::move to avoid an extra alloc (should be safe since _inputStates is not used after this)
-    _playbackInputs[0] = std::move(params._inputRecording[0]);
-    _playbackInputs[1] = std::move(params._inputRecording[1]);
-    _playbackInputs[2] = std::move(params._inputRecording[2]);
-    _playbackInputs[3] = std::move(params._inputRecording[3]);
+    return _isStepParked || (_isStepModeEnabled && CPU::GetState() == CPU::State::Running);
+}
 
-    if (Core::GetState() == Core::State::Paused)
+void Instance::RunWithCpuPaused(const std::function<void()>& job)
+{
+    if (Core::IsCPUThread())
     {
-        Core::SetState(Core::State::Running);
+        job();
+        return;
     }
-    
-    // This checks if any controllers have inputs. HasNext() is fine to call because nothing has been popped yet.
-    if (!_playbackInputs[0].HasNext()
-        && !_playbackInputs[1].HasNext()
-        && !_playbackInputs[2].HasNext()
-        && !_playbackInputs[3].HasNext())
+
+    std::unique_lock<std::mutex> ipcLock(_ipcReceiveMutex);
+
+    // Pausing a step in flight could catch the CPU thread on its way into the park, so wait for it to get there instead
+    while (IsStepDispatchOnCpuThread() && !_isStepParked)
     {
-        OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_PlayInputs);
+        _stepParkCondition.wait_for(ipcLock, StepParkPollInterval);
+    }
+
+    if (_isStepParked)
+    {
+        // The parked CPU thread is already at a frame boundary, so it runs the job itself
+        std::packaged_task<void()> parkedJob(job);
+        std::future<void> jobDone = parkedJob.get_future();
+        _parkedCpuJobs.push(std::move(parkedJob));
+        ipcLock.unlock();
+        _stepParkCondition.notify_all();
+        jobDone.wait();
         return;
     }
 
-    _instanceState = RecordingState::Playback;
+    ipcLock.unlock();
+    Core::RunAsCPUThread(job);
 }
 
-INSTANCE_FUNC_BODY(Instance, FrameAdvance, params)
+// Calls that only touch RAM or instance state, and so are safe to run from the CPU thread in the middle of a frame
+bool Instance::CanRunOnCpuThread(DolphinInstanceIpcCall call)
 {
-    _framesToAdvance = params._numFrames;
-
-    if (Core::GetState() == Core::State::Paused)
+    switch (call)
     {
-        Core::SetState(Core::State::Running);
+        case DolphinInstanceIpcCall::DolphinInstance_StepFrames:
+        case DolphinInstanceIpcCall::DolphinInstance_Step:
+        case DolphinInstanceIpcCall::DolphinInstance_ConfigureObservation:
+        case DolphinInstanceIpcCall::DolphinInstance_ConfigureStateHash:
+        case DolphinInstanceIpcCall::DolphinInstance_GetStateHash:
+        case DolphinInstanceIpcCall::DolphinInstance_ScheduleCommand:
+        case DolphinInstanceIpcCall::DolphinInstance_ConfigureTasInputQueue:
+        case DolphinInstanceIpcCall::DolphinInstance_QueueTasInputs:
+        case DolphinInstanceIpcCall::DolphinInstance_ClearTasInputQueue:
+        case DolphinInstanceIpcCall::DolphinInstance_SetTasInput:
+        case DolphinInstanceIpcCall::DolphinInstance_Heartbeat:
+        case DolphinInstanceIpcCall::DolphinInstance_ReadMemory:
+        case DolphinInstanceIpcCall::DolphinInstance_ReadMemoryTyped:
+        case DolphinInstanceIpcCall::DolphinInstance_WriteMemory:
+        case DolphinInstanceIpcCall::DolphinInstance_WriteMemoryTyped:
+            return true;
+        default:
+            return false;
     }
 }
 
-INSTANCE_FUNC_BODY(Instance, SetTasInput, params)
+// Calls that pause, resume or take over emulation themselves, after which a scheduled break must not be lifted
+bool Instance::ControlsRunState(DolphinInstanceIpcCall call)
 {
-    _tasInputStates[0] = params._tasInputStates[0];
-    _tasInputStates[1] = params._tasInputStates[1];
-    _tasInputStates[2] = params._tasInputStates[2];
-    _tasInputStates[3] = params._tasInputStates[3];
+    switch (call)
+    {
+        case DolphinInstanceIpcCall::DolphinInstance_Terminate:
+        case DolphinInstanceIpcCall::DolphinInstance_PauseEmulation:
+        case DolphinInstanceIpcCall::DolphinInstance_ResumeEmulation:
+        case DolphinInstanceIpcCall::DolphinInstance_PlayInputs:
+        case DolphinInstanceIpcCall::DolphinInstance_FrameAdvance:
+        case DolphinInstanceIpcCall::DolphinInstance_RewindToFrame:
+        case DolphinInstanceIpcCall::DolphinInstance_SetStepMode:
+        case DolphinInstanceIpcCall::DolphinInstance_SearchInputs:
+            return true;
+        default:
+            return false;
+    }
 }
 
-INSTANCE_FUNC_BODY(Instance, CreateSaveState, params)
+void Instance::RunScheduledCommands()
 {
-    if (!params._filePathNoExtension.empty())
+    const u64 frameNumber = Movie::GetCurrentFrame();
+
+    if (frameNumber < _nextScheduledFrame.load(std::memory_order_relaxed))
     {
-        // Dump the save state
-        std::string savFile = params._filePathNoExtension + ".sav";
-        if (File::Exists(savFile))
-        {
-            File::Delete(savFile);
-        }
-        State::SaveAs(savFile, true);
+        return;
+    }
+
+    std::vector<ScheduledCommand> dueCommands;
 
-        // Dump memory card info for this game
-        if (params._saveMemoryCards)
+    {
+        std::lock_guard<std::mutex> scheduleLock(_scheduleMutex);
+
+        while (!_scheduledCommands.empty() && _scheduledCommands.top()._frameNumber <= frameNumber)
         {
-            std::string cardAFile = params._filePathNoExtension + ".cardA.gci";
-            std::string cardBFile = params._filePathNoExtension + ".cardB.gci";
-            InstanceUtils::ExportGci(DolphinSlot::SlotA, cardAFile);
-            InstanceUtils::ExportGci(DolphinSlot::SlotB, cardBFile);
+            dueCommands.push_back(_scheduledCommands.top());
+            _scheduledCommands.pop();
         }
-    }
 
-    CREATE_TO_SERVER_DATA(OnInstanceSaveStateCreated, ipcData, data)
-    data->_filePathNoExtension = params._filePathNoExtension;
-    data->_inputRecording[0] = _recordingInputs[0];
-    data->_inputRecording[1] = _recordingInputs[1];
-    data->_inputRecording[2] = _recordingInputs[2];
-    data->_inputRecording[3] = _recordingInputs[3];
-    ipcSendToServer(ipcData);
+        _nextScheduledFrame = _scheduledCommands.empty() ? std::numeric_limits<u64>::max() : _scheduledCommands.top()._frameNumber;
+    }
 
-    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_CreateSaveState);
-}
+    std::vector<ScheduledCommand> hostCommands;
 
-INSTANCE_FUNC_BODY(Instance, LoadSaveState, params)
-{
-    if (File::Exists(params._saveFilePath))
+    for (ScheduledCommand& scheduled : dueCommands)
     {
-        State::LoadAs(params._saveFilePath);
+        // Once one call has to go through the host thread, the ones after it follow to keep their order
+        if (hostCommands.empty() && CanRunOnCpuThread(scheduled._command._call))
+        {
+            ExecuteScheduledCommand(scheduled, frameNumber);
+        }
+        else
+        {
+            hostCommands.push_back(std::move(scheduled));
+        }
     }
 
-    if (File::Exists(params._optionalMemoryCardDataAPath))
+    if (hostCommands.empty())
     {
-        InstanceUtils::ImportGci(DolphinSlot::SlotA, params._optionalMemoryCardDataAPath);
+        return;
     }
 
-    if (File::Exists(params._optionalMemoryCardDataBPath))
+    // Stop on this frame, run the rest on the host thread, then carry on as if nothing happened
+    CPU::Break();
+    Core::QueueHostJob([=]
     {
-        InstanceUtils::ImportGci(DolphinSlot::SlotB, params._optionalMemoryCardDataBPath);
-    }
+        bool shouldResume = true;
 
-    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_LoadSaveState);
+        for (const ScheduledCommand& scheduled : hostCommands)
+        {
+            ExecuteScheduledCommand(scheduled, frameNumber);
+            shouldResume = shouldResume && !ControlsRunState(scheduled._command._call);
+        }
+
+        // A finished step stays parked, StepFrames lifts the break as usual
+        if (shouldResume && (!_isStepModeEnabled || _stepFramesRemaining > 0))
+        {
+            CPU::EnableStepping(false);
+        }
+    });
 }
 
-INSTANCE_FUNC_BODY(Instance, LoadMemoryCardData, params)
+void Instance::SendTasInputQueueStatus(bool isLowWater, const int* droppedInputs)
 {
-    if (File::Exists(params._optionalMemoryCardDataAPath))
-    {
-        InstanceUtils::ImportGci(DolphinSlot::SlotA, params._optionalMemoryCardDataAPath);
-    }
+    CREATE_TO_SERVER_DATA(OnInstanceTasInputQueueStatus, ipcData, data)
+    data->_frameNumber = Movie::GetCurrentFrame();
+    data->_isLowWater = isLowWater;
+    _tasInputQueue.GetQueuedFrames(data->_queuedFrames);
 
-    if (File::Exists(params._optionalMemoryCardDataBPath))
+    if (droppedInputs)
     {
-        InstanceUtils::ImportGci(DolphinSlot::SlotB, params._optionalMemoryCardDataBPath);
+        std::copy(droppedInputs, droppedInputs + TasInputQueue::NUM_CONTROLLERS, data->_droppedInputs);
     }
 
-    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_LoadMemoryCardData);
+    ipcSendToServer(ipcData);
 }
 
-INSTANCE_FUNC_BODY(Instance, FormatMemoryCard, params)
+void Instance::ExecuteScheduledCommand(const ScheduledCommand& scheduled, u64 executedFrame)
 {
-    InstanceUtils::FormatMemoryCard(params._slot, params._encoding, params._cardSize);
+    CREATE_TO_SERVER_DATA(OnInstanceScheduledCommandExecuted, ipcData, data)
+    data->_scheduleId = scheduled._scheduleId;
+    data->_call = scheduled._command._call;
+    data->_requestedFrame = scheduled._frameNumber;
+    data->_executedFrame = executedFrame;
+    ipcSendToServer(ipcData);
 
-    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_FormatMemoryCard);
+    onServerToInstanceDataReceived(scheduled._command);
 }
 
-INSTANCE_FUNC_BODY(Instance, ReadMemory, params)
+bool Instance::VerifyPlaybackRamHash()
 {
-    u32 address = InstanceUtils::ResolvePointer(params._address, params._pointerOffsets);
+    u64 pollIndex = 0;
+    u64 expectedHash = 0;
+    u64 actualHash = 0;
 
-    CREATE_TO_SERVER_DATA(OnInstanceMemoryRead, ipcData, data)
-    data->_bytes = InstanceUtils::ReadBytes(address, params._numberOfBytes);
-    ipcSendToServer(ipcData);
-
-    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_ReadMemory);
-}
+    if (_ramHashChecker.VerifyPoll(pollIndex, expectedHash, actualHash))
+    {
+        return true;
+    }
 
-INSTANCE_FUNC_BODY(Instance, WriteMemory, params)
-{
-    u32 address = InstanceUtils::ResolvePointer(params._address, params._pointerOffsets);
+    // Break directly on the CPU thread so emulation stops on the diverged frame, then end the playback as if it had completed
+    CPU::Break();
+    _instanceState = RecordingState::None;
 
-    CREATE_TO_SERVER_DATA(OnInstanceMemoryWrite, ipcData, data)
-    data->_success = InstanceUtils::WriteBytes(address, params._bytes);
+    CREATE_TO_SERVER_DATA(OnInstanceDesyncDetected, ipcData, data)
+    data->_frameNumber = Movie::GetCurrentFrame();
+    data->_pollIndex = pollIndex;
+    data->_expectedHash = expectedHash;
+    data->_actualHash = actualHash;
     ipcSendToServer(ipcData);
 
-    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_WriteMemory);
+    Core::QueueHostJob([=]
+    {
+        OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_PlayInputs, EndTimedRun());
+    });
+
+    return false;
 }
 
-void Instance::UpdateRunningFlag()
+void Instance::CheckGcFrameAdvance(GCPadStatus* padStatus, int controllerId, bool checkInputs)
 {
-    updateIpcListen();
+    UpdateMemoryWatches();
+    UpdateSharedRam();
+    UpdateMemoryTriggers();
+    UpdateRamDiff();
 
-    if (_mockServer)
+    // Perform frame advance
+    if (_framesToAdvance > 0)
     {
-        _mockServer->Update();
-    }
+        if (checkInputs && !_shouldUseHardwareController)
+        {
+            // Replace hardware input with TAS input
+            InstanceUtils::CopyControllerStateToGcPadStatus(_tasInputStates[controllerId], padStatus);
+        }
 
-    // Close if no heartbeat command sent over IPC recently
-    if (std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now() - _lastHeartbeat) > std::chrono::seconds(15))
+        bool isAdvanceComplete = false;
+
+        if (_frameAdvanceSkipsLagFrames)
+        {
+            // Only polled frames count, however many times the game polls during one
+            isAdvanceComplete = _isFirstPollOfFrame && --_framesToAdvance <= 0;
+        }
+        else
+        {
+            // Every emulated frame counts, lag frames included, so the advance ends at the first poll on or past its end frame
+            isAdvanceComplete = Movie::GetCurrentFrame() >= _frameAdvanceEndFrame;
+        }
+
+        if (isAdvanceComplete)
+        {
+            _framesToAdvance = 0;
+
+            Core::QueueHostJob([=]
+            {
+                // A step mode CPU stops in its park by itself, and a pause from the host thread would end that park
+                if (!_isStepModeEnabled)
+                {
+                    Core::SetState(Core::State::Paused);
+                }
+
+                OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_FrameAdvance, EndTimedRun());
+            });
+        }
+    }
+
+    // Update stored input states, which will be applied to the game and potentially recordings (either from TAS input or hardware controller)
+    if (checkInputs)
+    {
+        InstanceUtils::CopyGcPadStatusToControllerState(padStatus, _hardwareInputStates[controllerId]);
+    }
+}
+
+// Host thread, before loading a state. The end frame is parked out of reach until the load is done, so a frame advance
+// in flight cannot end early on the loaded frame. Returns the frames it still had to go.
+u64 Instance::HoldFrameAdvance()
+{
+    u64 endFrame = _frameAdvanceEndFrame.exchange(std::numeric_limits<u64>::max());
+    u64 currentFrame = Movie::GetCurrentFrame();
+
+    return endFrame > currentFrame ? endFrame - currentFrame : 0;
+}
+
+// Host thread, after loading a state (or failing to). The frames left are counted from the frame emulation resumes on.
+void Instance::RebaseFrameAdvance(u64 framesRemaining)
+{
+    _frameAdvanceEndFrame = Movie::GetCurrentFrame() + framesRemaining;
+}
+
+void Instance::UpdateMemoryWatches()
+{
+    if (!_memoryWatcher.HasWatches())
+    {
+        return;
+    }
+
+    u64 frameNumber = Movie::GetCurrentFrame();
+    std::vector<DolphinMemoryWatchChange> changes = _memoryWatcher.Sample(frameNumber);
+
+    // Stable values cost nothing over IPC, only changed regions are pushed
+    if (!changes.empty())
+    {
+        CREATE_TO_SERVER_DATA(OnInstanceMemoryWatchChanged, ipcData, data)
+        data->_frameNumber = frameNumber;
+        data->_changes = std::move(changes);
+        ipcSendToServer(ipcData);
+    }
+}
+
+void Instance::UpdateMemoryTriggers()
+{
+    if (!_memoryTriggers.HasTriggers())
+    {
+        return;
+    }
+
+    bool shouldPause = false;
+    std::vector<int> firedTriggerIds = _memoryTriggers.Evaluate(shouldPause);
+
+    if (firedTriggerIds.empty())
+    {
+        return;
+    }
+
+    // Break directly on the CPU thread, rather than queueing a host job, so that emulation stops on this exact frame
+    if (shouldPause)
+    {
+        CPU::Break();
+    }
+
+    CREATE_TO_SERVER_DATA(OnInstanceMemoryTriggerFired, ipcData, data)
+    data->_frameNumber = Movie::GetCurrentFrame();
+    data->_triggerIds = std::move(firedTriggerIds);
+    data->_paused = shouldPause;
+    ipcSendToServer(ipcData);
+}
+
+void Instance::UpdateRamDiff()
+{
+    if (!_ramDiffer.IsActive())
+    {
+        return;
+    }
+
+    u64 frameNumber = Movie::GetCurrentFrame();
+    u64 fromFrame = 0;
+    std::vector<DolphinRamSpan> spans;
+
+    if (!_ramDiffer.Update(frameNumber, spans, fromFrame))
+    {
+        return;
+    }
+
+    std::vector<DolphinRamSpan> partSpans;
+    size_t partBytes = 0;
+
+    auto sendPart = [&](bool isLastPart)
+    {
+        CREATE_TO_SERVER_DATA(OnInstanceRamDiff, ipcData, data)
+        data->_fromFrame = fromFrame;
+        data->_toFrame = frameNumber;
+        data->_spans = std::move(partSpans);
+        data->_isLastPart = isLastPart;
+        ipcSendToServer(ipcData);
+
+        partSpans.clear();
+        partBytes = 0;
+    };
+
+    // The address, size and byte count of every span count towards the limit as well as its contents
+    const size_t maxPartBytes = ToServerParams_OnInstanceRamDiff::MaxBytesPerMessage;
+    const size_t spanOverhead = 16;
+
+    for (DolphinRamSpan& span : spans)
+    {
+        const size_t spanSize = span.Bytes.size();
+        size_t offset = 0;
+
+        do
+        {
+            if (partBytes + spanOverhead >= maxPartBytes)
+            {
+                sendPart(false);
+            }
+
+            size_t pieceSize = std::min(spanSize - offset, maxPartBytes - spanOverhead - partBytes);
+
+            if (pieceSize == spanSize)
+            {
+                partSpans.push_back(std::move(span));
+            }
+            else
+            {
+                DolphinRamSpan piece;
+                piece.Address = span.Address + u32(offset);
+                piece.Size = u32(pieceSize);
+                piece.Bytes.assign(span.Bytes.begin() + offset, span.Bytes.begin() + offset + pieceSize);
+                partSpans.push_back(std::move(piece));
+            }
+
+            offset += pieceSize;
+            partBytes += spanOverhead + pieceSize;
+        } while (offset < spanSize);
+    }
+
+    sendPart(true);
+}
+
+void Instance::UpdateSharedRam()
+{
+    if (!_sharedRamView)
+    {
+        return;
+    }
+
+    u64 frameNumber = Movie::GetCurrentFrame();
+
+    if (frameNumber >= _nextSharedRamPublishFrame)
+    {
+        _sharedRamView->publish(frameNumber);
+        _nextSharedRamPublishFrame = frameNumber + u64(_sharedRamPublishIntervalFrames);
+    }
+}
+
+void Instance::RefreshSharedRam()
+{
+    if (!_sharedRamView)
+    {
+        return;
+    }
+
+    // Readers see RAM live, this only tells them it changed outside of a frame boundary (ie memory writes while paused)
+    _sharedRamView->publish(Movie::GetCurrentFrame());
+}
+
+INSTANCE_FUNC_BODY(Instance, Connect, params)
+{
+}
+
+INSTANCE_FUNC_BODY(Instance, Heartbeat, params)
+{
+    _lastHeartbeat = std::chrono::system_clock::now();
+    _shouldUseHardwareController = params._shouldUseHardwareController;
+
+    // Acknowledge heartbeat, sending over any state data the server may want.
+    CREATE_TO_SERVER_DATA(OnInstanceHeartbeatAcknowledged, ipcData, data)
+    data->_isRecording = _instanceState == RecordingState::Recording;
+    data->_isPaused = Core::GetState() == Core::State::Paused;
+    data->_hardwareInputStates[0] = _hardwareInputStates[0];
+    data->_hardwareInputStates[1] = _hardwareInputStates[1];
+    data->_hardwareInputStates[2] = _hardwareInputStates[2];
+    data->_hardwareInputStates[3] = _hardwareInputStates[3];
+    data->_lagFrameCount = Movie::GetCurrentLagCount();
+    data->_lagFrames = _lagFrameTracker.TakeSinceLastTake();
+    ipcSendToServer(ipcData);
+}
+
+INSTANCE_FUNC_BODY(Instance, Terminate, params)
+{
+    StopRecording();
+    RequestShutdown();
+}
+
+INSTANCE_FUNC_BODY(Instance, StartRecordingInput, params)
+{
+    StopRecording();
+    StartRecording(params._ramHashIntervalFrames);
+
+    _isRecordingController[0] = params._recordControllers[0];
+    _isRecordingController[1] = params._recordControllers[1];
+    _isRecordingController[2] = params._recordControllers[2];
+    _isRecordingController[3] = params._recordControllers[3];
+
+    if (params._unpauseInstance)
+    {
+        if (Core::GetState() == Core::State::Paused)
+        {
+            Core::SetState(Core::State::Running);
+        }
+    }
+
+    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_StartRecordingInput);
+}
+
+INSTANCE_FUNC_BODY(Instance, StopRecordingInput, params)
+{
+    StopRecording();
+    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_StopRecordingInput);
+}
+
+INSTANCE_FUNC_BODY(Instance, PauseEmulation, params)
+{
+    if (Core::GetState() == Core::State::Running)
+    {
+        Core::SetState(Core::State::Paused);
+    }
+
+    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_PauseEmulation);
+}
+
+INSTANCE_FUNC_BODY(Instance, ResumeEmulation, params)
+{
+    if (Core::GetState() == Core::State::Paused)
+    {
+        Core::SetState(Core::State::Running);
+    }
+
+    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_ResumeEmulation);
+}
+
+INSTANCE_FUNC_BODY(Instance, PlayInputs, params)
+{
+    // These vectors can be masive, use std::move to avoid an extra alloc (should be safe since _inputStates is not used after this)
+    _playbackInputs[0] = std::move(params._inputRecording[0]);
+    _playbackInputs[1] = std::move(params._inputRecording[1]);
+    _playbackInputs[2] = std::move(params._inputRecording[2]);
+    _playbackInputs[3] = std::move(params._inputRecording[3]);
+    _ramHashChecker.StartPlayback(params._ramHashes);
+
+    BeginTimedRun(params._turbo);
+
+    if (Core::GetState() == Core::State::Paused)
+    {
+        Core::SetState(Core::State::Running);
+    }
+    
+    // This checks if any controllers have inputs. HasNext() is fine to call because nothing has been popped yet.
+    if (!_playbackInputs[0].HasNext()
+        && !_playbackInputs[1].HasNext()
+        && !_playbackInputs[2].HasNext()
+        && !_playbackInputs[3].HasNext())
+    {
+        OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_PlayInputs, EndTimedRun());
+        return;
+    }
+
+    _instanceState = RecordingState::Playback;
+}
+
+INSTANCE_FUNC_BODY(Instance, FrameAdvance, params)
+{
+    BeginTimedRun(params._turbo);
+    _frameAdvanceEndFrame = Movie::GetCurrentFrame() + u64(std::max(params._numFrames, 0));
+    _framesToAdvance = params._numFrames;
+    _frameAdvanceSkipsLagFrames = params._skipLagFrames;
+
+    if (Core::GetState() == Core::State::Paused)
+    {
+        Core::SetState(Core::State::Running);
+    }
+}
+
+INSTANCE_FUNC_BODY(Instance, SetStepMode, params)
+{
+    _stepFramesRemaining = 0;
+    _isStepUsingTasInput = false;
+    _isStepModeEnabled = params._enabled;
+
+    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_SetStepMode);
+}
+
+INSTANCE_FUNC_BODY(Instance, StepFrames, params)
+{
+    if (!_isStepModeEnabled || params._numFrames <= 0)
+    {
+        OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_StepFrames);
+        return;
+    }
+
+    BeginStep(params._numFrames, false);
+}
+
+INSTANCE_FUNC_BODY(Instance, ConfigureObservation, params)
+{
+    _stepObserver.Configure(params._memoryRegions, params._framebufferWidth, params._framebufferHeight, params._framebufferGrayscale);
+
+    // The framebuffer is read back from the XFB in RAM, which is skipped by default
+    if (_stepObserver.WantsFramebuffer())
+    {
+        Config::SetCurrent(Config::GFX_HACK_SKIP_XFB_COPY_TO_RAM, false);
+    }
+
+    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_ConfigureObservation);
+}
+
+INSTANCE_FUNC_BODY(Instance, Step, params)
+{
+    _tasInputStates[0] = params._tasInputStates[0];
+    _tasInputStates[1] = params._tasInputStates[1];
+    _tasInputStates[2] = params._tasInputStates[2];
+    _tasInputStates[3] = params._tasInputStates[3];
+
+    if (params._numFrames <= 0)
+    {
+        CREATE_TO_SERVER_DATA(OnInstanceStepCompleted, ipcData, data)
+        _stepObserver.Capture(*data);
+        data->_stateHash = _stateHasher.Compute();
+        ipcSendToServer(ipcData);
+        return;
+    }
+
+    // Step implies step mode, so a Step loop needs no separate setup call. Its inputs apply for the stepped frames whatever
+    // the heartbeat last said about hardware controllers.
+    _isStepModeEnabled = true;
+    _isStepUsingTasInput = true;
+    BeginStep(params._numFrames, true);
+}
+
+INSTANCE_FUNC_BODY(Instance, ConfigureStateHash, params)
+{
+    _stateHasher.Configure(params._memoryRegions, params._excludedRegions, params._blockSize);
+
+    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_ConfigureStateHash);
+}
+
+INSTANCE_FUNC_BODY(Instance, GetStateHash, params)
+{
+    CREATE_TO_SERVER_DATA(OnInstanceStateHash, ipcData, data)
+    data->_frameNumber = Movie::GetCurrentFrame();
+    data->_stateHash = _stateHasher.Compute();
+    ipcSendToServer(ipcData);
+
+    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_GetStateHash);
+}
+
+INSTANCE_FUNC_BODY(Instance, ScheduleCommand, params)
+{
+    if (params._command && params._command->_call != DolphinInstanceIpcCall::Null)
+    {
+        std::lock_guard<std::mutex> scheduleLock(_scheduleMutex);
+
+        ScheduledCommand scheduled;
+        scheduled._frameNumber = params._frameNumber;
+        scheduled._sequence = _scheduleSequence++;
+        scheduled._scheduleId = params._scheduleId;
+        scheduled._command = *params._command;
+
+        _scheduledCommands.push(std::move(scheduled));
+        _nextScheduledFrame = _scheduledCommands.top()._frameNumber;
+    }
+
+    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_ScheduleCommand);
+}
+
+INSTANCE_FUNC_BODY(Instance, ConfigureRewind, params)
+{
+    _rewindBuffer.Configure(params._intervalFrames, params._maxCheckpoints);
+
+    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_ConfigureRewind);
+}
+
+INSTANCE_FUNC_BODY(Instance, RewindToFrame, params)
+{
+    // Rewinding would desync the playback and recording streams, which are not indexed by frame
+    if (_instanceState != RecordingState::None)
+    {
+        Log(Common::Log::LogLevel::LWARNING, "Rewind is unavailable while playing back or recording inputs");
+        OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_RewindToFrame);
+        return;
+    }
+
+    // Re-simulate at uncapped speed, the previous speed is restored once the target frame is reached
+    float previousEmulationSpeed = Config::Get(Config::MAIN_EMULATION_SPEED);
+    Config::SetCurrent(Config::MAIN_EMULATION_SPEED, 0.0f);
+
+    if (!_rewindBuffer.BeginRewind(params._frameNumber))
+    {
+        Config::SetCurrent(Config::MAIN_EMULATION_SPEED, previousEmulationSpeed);
+        OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_RewindToFrame);
+        return;
+    }
+
+    _rewindPreviousEmulationSpeed = previousEmulationSpeed;
+
+    if (Core::GetState() == Core::State::Paused)
+    {
+        Core::SetState(Core::State::Running);
+    }
+}
+
+INSTANCE_FUNC_BODY(Instance, SearchInputs, params)
+{
+    // Candidates reload the root state, which would desync the playback and recording streams
+    if (_instanceState != RecordingState::None || _rewindBuffer.IsReplaying())
+    {
+        Log(Common::Log::LogLevel::LWARNING, "Input search is unavailable while playing back, recording or rewinding");
+        CREATE_TO_SERVER_DATA(OnInstanceInputSearchCompleted, ipcData, data)
+        ipcSendToServer(ipcData);
+        return;
+    }
+
+    BeginTimedRun(true);
+
+    if (!_inputSearch.Begin(params._controllerId, params._frames, params._horizonFrames, params._objective, params._topK, params._maxCandidates))
+    {
+        EndTimedRun();
+        CREATE_TO_SERVER_DATA(OnInstanceInputSearchCompleted, ipcData, data)
+        ipcSendToServer(ipcData);
+        return;
+    }
+
+    if (Core::GetState() == Core::State::Paused)
+    {
+        Core::SetState(Core::State::Running);
+    }
+}
+
+INSTANCE_FUNC_BODY(Instance, SetTasInput, params)
+{
+    _tasInputStates[0] = params._tasInputStates[0];
+    _tasInputStates[1] = params._tasInputStates[1];
+    _tasInputStates[2] = params._tasInputStates[2];
+    _tasInputStates[3] = params._tasInputStates[3];
+}
+
+INSTANCE_FUNC_BODY(Instance, ConfigureTasInputQueue, params)
+{
+    _tasInputQueue.Configure(params._capacityFrames, params._lowWaterFrames);
+
+    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_ConfigureTasInputQueue);
+}
+
+INSTANCE_FUNC_BODY(Instance, QueueTasInputs, params)
+{
+    int droppedInputs[TasInputQueue::NUM_CONTROLLERS] = {};
+
+    for (int controllerId = 0; controllerId < TasInputQueue::NUM_CONTROLLERS; controllerId++)
+    {
+        droppedInputs[controllerId] = _tasInputQueue.Push(controllerId, params._inputs[controllerId]);
+    }
+
+    SendTasInputQueueStatus(false, droppedInputs);
+
+    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_QueueTasInputs);
+}
+
+INSTANCE_FUNC_BODY(Instance, ClearTasInputQueue, params)
+{
+    _tasInputQueue.Clear();
+
+    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_ClearTasInputQueue);
+}
+
+INSTANCE_FUNC_BODY(Instance, CreateSaveState, params)
+{
+    std::array<DolphinInputRecording, 4> inputRecordings = { _recordingInputs[0], _recordingInputs[1], _recordingInputs[2], _recordingInputs[3] };
+    auto notifySaveStateCreated = [this, filePathNoExtension = params._filePathNoExtension, inputRecordings = std::move(inputRecordings)]
+    {
+        CREATE_TO_SERVER_DATA(OnInstanceSaveStateCreated, ipcData, data)
+        data->_filePathNoExtension = filePathNoExtension;
+        data->_inputRecording[0] = inputRecordings[0];
+        data->_inputRecording[1] = inputRecordings[1];
+        data->_inputRecording[2] = inputRecordings[2];
+        data->_inputRecording[3] = inputRecordings[3];
+        ipcSendToServer(ipcData);
+    };
+
+    if (!params._filePathNoExtension.empty())
+    {
+        // Emulation resumes as soon as the state is captured. The server hears about the save once the files are durable.
+        _saveStateWriter.Save(params._filePathNoExtension, params._saveMemoryCards, [notifySaveStateCreated = std::move(notifySaveStateCreated)]
+        {
+            Core::QueueHostJob(notifySaveStateCreated);
+        });
+    }
+    else
+    {
+        notifySaveStateCreated();
+    }
+
+    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_CreateSaveState);
+}
+
+INSTANCE_FUNC_BODY(Instance, LoadSaveState, params)
+{
+    _saveStateWriter.WaitForIdle();
+
+    if (File::Exists(params._saveFilePath))
+    {
+        u64 framesToAdvance = HoldFrameAdvance();
+        State::LoadAs(params._saveFilePath);
+        RebaseFrameAdvance(framesToAdvance);
+        RefreshSharedRam();
+        _rewindBuffer.Invalidate();
+    }
+
+    if (File::Exists(params._optionalMemoryCardDataAPath))
+    {
+        InstanceUtils::ImportGci(DolphinSlot::SlotA, params._optionalMemoryCardDataAPath);
+    }
+
+    if (File::Exists(params._optionalMemoryCardDataBPath))
+    {
+        InstanceUtils::ImportGci(DolphinSlot::SlotB, params._optionalMemoryCardDataBPath);
+    }
+
+    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_LoadSaveState);
+}
+
+INSTANCE_FUNC_BODY(Instance, SaveStateToSlot, params)
+{
+    _stateSlots.Save(params._slot, params._baseSlot, params._maxChainDepth);
+
+    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_SaveStateToSlot);
+}
+
+INSTANCE_FUNC_BODY(Instance, LoadStateFromSlot, params)
+{
+    u64 framesToAdvance = HoldFrameAdvance();
+
+    if (_stateSlots.Load(params._slot))
+    {
+        RefreshSharedRam();
+        _rewindBuffer.Invalidate();
+    }
+
+    RebaseFrameAdvance(framesToAdvance);
+
+    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_LoadStateFromSlot);
+}
+
+INSTANCE_FUNC_BODY(Instance, FreeStateSlots, params)
+{
+    _stateSlots.Free(params._slots);
+
+    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_FreeStateSlots);
+}
+
+INSTANCE_FUNC_BODY(Instance, ListStateSlots, params)
+{
+    CREATE_TO_SERVER_DATA(OnInstanceStateSlotsListed, ipcData, data)
+    data->_slots = _stateSlots.List();
+    data->_totalSizeBytes = _stateSlots.GetTotalSize();
+    ipcSendToServer(ipcData);
+
+    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_ListStateSlots);
+}
+
+INSTANCE_FUNC_BODY(Instance, PersistStateSlot, params)
+{
+    if (!params._filePathNoExtension.empty())
+    {
+        _saveStateWriter.WaitForIdle();
+        _stateSlots.Persist(params._slot, params._filePathNoExtension + ".sav");
+    }
+
+    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_PersistStateSlot);
+}
+
+INSTANCE_FUNC_BODY(Instance, SaveStateToStore, params)
+{
+    std::vector<u8> stateBuffer;
+    State::SaveToBuffer(stateBuffer);
+
+    SaveStateStoreResult result = _saveStateStore.Save(params._storeDirectory, params._stateName, stateBuffer, params._chunkSize);
+
+    CREATE_TO_SERVER_DATA(OnInstanceStateStored, ipcData, data)
+    data->_stateName = params._stateName;
+    data->_success = result.success;
+    data->_totalChunks = result.totalChunks;
+    data->_newChunks = result.newChunks;
+    data->_bytesWritten = result.bytesWritten;
+    ipcSendToServer(ipcData);
+
+    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_SaveStateToStore);
+}
+
+INSTANCE_FUNC_BODY(Instance, LoadStateFromStore, params)
+{
+    std::vector<u8> stateBuffer;
+
+    if (_saveStateStore.Load(params._storeDirectory, params._stateName, stateBuffer))
+    {
+        u64 framesToAdvance = HoldFrameAdvance();
+        State::LoadFromBuffer(stateBuffer);
+        RebaseFrameAdvance(framesToAdvance);
+        RefreshSharedRam();
+        _rewindBuffer.Invalidate();
+    }
+
+    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_LoadStateFromStore);
+}
+
+INSTANCE_FUNC_BODY(Instance, CreateSaveStateData, params)
+{
+    // The server has had until now to copy out the previous payloads
+    _outgoingPayloads.clear();
+
+    std::vector<u8> stateBuffer;
+    State::SaveToBuffer(stateBuffer);
+
+    CREATE_TO_SERVER_DATA(OnInstanceSaveStateData, ipcData, data)
+    data->_state = CreatePayload(std::move(stateBuffer), "state", params._useSharedMemory);
+
+    if (params._saveMemoryCards)
+    {
+        std::vector<u8> cardImage;
+
+        if (InstanceUtils::ReadMemoryCardImage(DolphinSlot::SlotA, cardImage))
+        {
+            data->_memoryCardA = CreatePayload(std::move(cardImage), "cardA", params._useSharedMemory);
+        }
+
+        if (InstanceUtils::ReadMemoryCardImage(DolphinSlot::SlotB, cardImage))
+        {
+            data->_memoryCardB = CreatePayload(std::move(cardImage), "cardB", params._useSharedMemory);
+        }
+    }
+
+    data->_inputRecording[0] = _recordingInputs[0];
+    data->_inputRecording[1] = _recordingInputs[1];
+    data->_inputRecording[2] = _recordingInputs[2];
+    data->_inputRecording[3] = _recordingInputs[3];
+    ipcSendToServer(ipcData);
+
+    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_CreateSaveStateData);
+}
+
+INSTANCE_FUNC_BODY(Instance, LoadSaveStateData, params)
+{
+    std::vector<u8> payloadBytes;
+
+    if (ResolvePayload(params._state, payloadBytes))
+    {
+        u64 framesToAdvance = HoldFrameAdvance();
+        State::LoadFromBuffer(payloadBytes);
+        RebaseFrameAdvance(framesToAdvance);
+        RefreshSharedRam();
+        _rewindBuffer.Invalidate();
+    }
+
+    if (ResolvePayload(params._optionalMemoryCardA, payloadBytes))
+    {
+        InstanceUtils::WriteMemoryCardImage(DolphinSlot::SlotA, payloadBytes);
+    }
+
+    if (ResolvePayload(params._optionalMemoryCardB, payloadBytes))
+    {
+        InstanceUtils::WriteMemoryCardImage(DolphinSlot::SlotB, payloadBytes);
+    }
+
+    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_LoadSaveStateData);
+}
+
+INSTANCE_FUNC_BODY(Instance, LoadMemoryCardData, params)
+{
+    if (File::Exists(params._optionalMemoryCardDataAPath))
+    {
+        InstanceUtils::ImportGci(DolphinSlot::SlotA, params._optionalMemoryCardDataAPath);
+    }
+
+    if (File::Exists(params._optionalMemoryCardDataBPath))
+    {
+        InstanceUtils::ImportGci(DolphinSlot::SlotB, params._optionalMemoryCardDataBPath);
+    }
+
+    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_LoadMemoryCardData);
+}
+
+INSTANCE_FUNC_BODY(Instance, FormatMemoryCard, params)
+{
+    InstanceUtils::FormatMemoryCard(params._slot, params._encoding, params._cardSize);
+
+    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_FormatMemoryCard);
+}
+
+INSTANCE_FUNC_BODY(Instance, FlushMemoryCards, params)
+{
+    InstanceUtils::FlushMemoryCards();
+
+    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_FlushMemoryCards);
+}
+
+INSTANCE_FUNC_BODY(Instance, ReadMemoryCardImage, params)
+{
+    _outgoingPayloads.clear();
+
+    std::vector<u8> cardImage;
+    InstanceUtils::ReadMemoryCardImage(params._slot, cardImage);
+
+    CREATE_TO_SERVER_DATA(OnInstanceMemoryCardImage, ipcData, data)
+    data->_slot = params._slot;
+    data->_image = CreatePayload(std::move(cardImage), params._slot == DolphinSlot::SlotA ? "cardA" : "cardB", params._useSharedMemory);
+    ipcSendToServer(ipcData);
+
+    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_ReadMemoryCardImage);
+}
+
+INSTANCE_FUNC_BODY(Instance, WriteMemoryCardImage, params)
+{
+    std::vector<u8> cardImage;
+
+    if (ResolvePayload(params._image, cardImage))
+    {
+        InstanceUtils::WriteMemoryCardImage(params._slot, cardImage);
+    }
+
+    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_WriteMemoryCardImage);
+}
+
+INSTANCE_FUNC_BODY(Instance, PersistMemoryCard, params)
+{
+    std::vector<u8> cardImage;
+
+    if (!params._filePath.empty() && InstanceUtils::ReadMemoryCardImage(params._slot, cardImage))
+    {
+        File::CreateFullPath(params._filePath);
+        File::IOFile file(params._filePath, "wb");
+        file.WriteBytes(cardImage.data(), cardImage.size());
+    }
+
+    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_PersistMemoryCard);
+}
+
+INSTANCE_FUNC_BODY(Instance, ReadMemory, params)
+{
+    u32 address = InstanceUtils::ResolvePointer(params._address, params._pointerOffsets);
+
+    CREATE_TO_SERVER_DATA(OnInstanceMemoryRead, ipcData, data)
+    data->_bytes = InstanceUtils::ReadBytes(address, params._numberOfBytes);
+    ipcSendToServer(ipcData);
+
+    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_ReadMemory);
+}
+
+INSTANCE_FUNC_BODY(Instance, WriteMemory, params)
+{
+    u32 address = InstanceUtils::ResolvePointer(params._address, params._pointerOffsets);
+
+    CREATE_TO_SERVER_DATA(OnInstanceMemoryWrite, ipcData, data)
+    data->_success = InstanceUtils::WriteBytes(address, params._bytes);
+    ipcSendToServer(ipcData);
+
+    RefreshSharedRam();
+
+    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_WriteMemory);
+}
+
+INSTANCE_FUNC_BODY(Instance, ReadMemoryTyped, params)
+{
+    u32 address = InstanceUtils::ResolvePointer(params._address, params._pointerOffsets);
+
+    CREATE_TO_SERVER_DATA(OnInstanceMemoryRead, ipcData, data)
+    data->_bytes = InstanceUtils::ReadTypedBytes(address, params._valueType, params._numberOfElements);
+    ipcSendToServer(ipcData);
+
+    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_ReadMemoryTyped);
+}
+
+INSTANCE_FUNC_BODY(Instance, WriteMemoryTyped, params)
+{
+    u32 address = InstanceUtils::ResolvePointer(params._address, params._pointerOffsets);
+
+    CREATE_TO_SERVER_DATA(OnInstanceMemoryWrite, ipcData, data)
+    data->_success = InstanceUtils::WriteTypedBytes(address, params._valueType, params._bytes);
+    ipcSendToServer(ipcData);
+
+    RefreshSharedRam();
+
+    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_WriteMemoryTyped);
+}
+
+INSTANCE_FUNC_BODY(Instance, SubscribeMemoryWatches, params)
+{
+    _memoryWatcher.Subscribe(params._watches, params._sampleIntervalFrames, params._clearExisting);
+
+    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_SubscribeMemoryWatches);
+}
+
+INSTANCE_FUNC_BODY(Instance, UnsubscribeMemoryWatches, params)
+{
+    _memoryWatcher.Unsubscribe(params._watchIds);
+
+    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_UnsubscribeMemoryWatches);
+}
+
+INSTANCE_FUNC_BODY(Instance, RegisterMemoryTriggers, params)
+{
+    _memoryTriggers.Register(params._triggers, params._clearExisting);
+
+    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_RegisterMemoryTriggers);
+}
+
+INSTANCE_FUNC_BODY(Instance, UnregisterMemoryTriggers, params)
+{
+    _memoryTriggers.Unregister(params._triggerIds);
+
+    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_UnregisterMemoryTriggers);
+}
+
+INSTANCE_FUNC_BODY(Instance, StartRamDiff, params)
+{
+    // The snapshot is taken at the next input poll, so the first diff covers exactly one frame
+    _ramDiffer.Start(params._numFrames, params._blockSize, params._includeBytes);
+
+    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_StartRamDiff);
+}
+
+INSTANCE_FUNC_BODY(Instance, StopRamDiff, params)
+{
+    _ramDiffer.Stop();
+
+    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_StopRamDiff);
+}
+
+INSTANCE_FUNC_BODY(Instance, ScanMemory, params)
+{
+    // Scan with the CPU thread paused, so that every pass sees a consistent image of RAM
+    Core::RunAsCPUThread([&]
+    {
+        _memoryScanner.Scan(params._valueType, params._compareType, params._value, params._rangeMax, params._newScan);
+    });
+
+    CREATE_TO_SERVER_DATA(OnInstanceMemoryScanned, ipcData, data)
+    data->_candidateCount = _memoryScanner.GetCandidateCount();
+    data->_addresses = _memoryScanner.GetCandidates(size_t(std::max(params._maxResults, 0)));
+    ipcSendToServer(ipcData);
+
+    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_ScanMemory);
+}
+
+INSTANCE_FUNC_BODY(Instance, ClearMemoryScan, params)
+{
+    _memoryScanner.Clear();
+
+    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_ClearMemoryScan);
+}
+
+INSTANCE_FUNC_BODY(Instance, ScanPointerPaths, params)
+{
+    if (_pointerScanner.IsRunning())
+    {
+        Log(Common::Log::LogLevel::LERROR, "Pointer scan requested while another pointer scan is still running");
+        OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_ScanPointerPaths);
+        return;
+    }
+
+    // Only the snapshot needs the CPU paused, the search runs on a worker pool while emulation continues
+    Core::RunAsCPUThread([&]
+    {
+        _pointerScanner.CaptureSnapshot();
+    });
+
+    PointerScanParameters scanParameters;
+    scanParameters.targetAddress = params._targetAddress;
+    scanParameters.maxDepth = params._maxDepth;
+    scanParameters.maxOffset = u32(std::max(params._maxOffset, 0));
+    scanParameters.staticRangeStart = params._staticRangeStart;
+    scanParameters.staticRangeEnd = params._staticRangeEnd;
+    scanParameters.maxResults = size_t(std::max(params._maxResults, 0));
+
+    _pointerScanner.Start(scanParameters, [this, targetAddress = params._targetAddress](std::vector<DolphinPointerPath> paths, bool truncated)
+    {
+        Core::QueueHostJob([this, targetAddress, paths = std::move(paths), truncated]
+        {
+            CREATE_TO_SERVER_DATA(OnInstancePointerPathsScanned, ipcData, data)
+            data->_targetAddress = targetAddress;
+            data->_truncated = truncated;
+            data->_paths = paths;
+            ipcSendToServer(ipcData);
+
+            OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_ScanPointerPaths);
+        });
+    });
+}
+
+INSTANCE_FUNC_BODY(Instance, SetSharedRamMapping, params)
+{
+    // Swap the mapping with the CPU paused, since the CPU thread publishes into it at frame boundaries, and setting it up
+    // briefly touches emulated RAM
+    Core::RunAsCPUThread([&]
+    {
+        _sharedRamView.reset();
+
+        if (params._enabled)
+        {
+            // Regions are laid out in Dolphin's memory arena in this order, with the L1 cache and fake VMEM only present when
+            // they are in use. The view checks every offset against the live memory before publishing it.
+            u64 mem1ArenaOffset = 0;
+            u64 mem2ArenaOffset = u64(Memory::GetRamSize()) + (Memory::m_pL1Cache ? Memory::GetL1CacheSize() : 0)
+                + (Memory::m_pFakeVMEM ? Memory::GetFakeVMemSize() : 0);
+
+            _sharedRamView = std::make_unique<SharedRamView>(_instanceId, Memory::m_pRAM, Memory::GetRamSizeReal(), mem1ArenaOffset,
+                Memory::m_pEXRAM, Memory::m_pEXRAM ? Memory::GetExRamSizeReal() : 0, mem2ArenaOffset);
+
+            if (_sharedRamView->isValid())
+            {
+                _sharedRamPublishIntervalFrames = std::max(params._publishIntervalFrames, 1);
+                _nextSharedRamPublishFrame = 0;
+                _sharedRamView->publish(Movie::GetCurrentFrame());
+            }
+            else
+            {
+                _sharedRamView.reset();
+            }
+        }
+    });
+
+    CREATE_TO_SERVER_DATA(OnInstanceSharedRamMapped, ipcData, data)
+    data->_enabled = _sharedRamView != nullptr;
+
+    if (_sharedRamView)
+    {
+        data->_mappingName = SharedRamView::getMappingName(_instanceId);
+        data->_mem1Size = _sharedRamView->getHeader()->_mem1Size;
+        data->_mem2Size = _sharedRamView->getHeader()->_mem2Size;
+    }
+
+    ipcSendToServer(ipcData);
+
+    OnCommandCompleted(DolphinInstanceIpcCall::DolphinInstance_SetSharedRamMapping);
+}
+
+DolphinPayload Instance::CreatePayload(std::vector<u8> bytes, const std::string& payloadName, bool useSharedMemory)
+{
+    DolphinPayload payload;
+
+    if (!useSharedMemory && bytes.size() <= DolphinPayload::MaxInlineSize)
+    {
+        payload.Bytes = std::move(bytes);
+        return payload;
+    }
+
+    // Every mapping gets a fresh name, since a name the server still holds open would map the old, possibly smaller, buffer
+    std::string mappingName = SharedPayloadBuffer::getMappingName(_instanceId, payloadName + "-" + std::to_string(_outgoingPayloadCounter++));
+    auto sharedPayload = std::make_unique<SharedPayloadBuffer>(mappingName, bytes.data(), bytes.size());
+
+    if (sharedPayload->isValid())
+    {
+        payload.SharedMappingName = mappingName;
+        _outgoingPayloads.push_back(std::move(sharedPayload));
+    }
+    else if (bytes.size() <= DolphinPayload::MaxInlineSize)
+    {
+        payload.Bytes = std::move(bytes);
+    }
+    else
+    {
+        // Left empty rather than sending a message the pipe would refuse
+        Log(Common::Log::LogLevel::LERROR, ("Could not share the " + payloadName + " payload, it is too large to send inline").c_str());
+    }
+
+    return payload;
+}
+
+bool Instance::ResolvePayload(const DolphinPayload& payload, std::vector<u8>& outBytes)
+{
+    if (payload.SharedMappingName.empty())
+    {
+        outBytes = payload.Bytes;
+        return !outBytes.empty();
+    }
+
+    SharedPayloadBuffer sharedPayload(payload.SharedMappingName);
+
+    if (!sharedPayload.isValid())
+    {
+        return false;
+    }
+
+    outBytes.assign(sharedPayload.getData(), sharedPayload.getData() + sharedPayload.getSize());
+
+    return !outBytes.empty();
+}
+
+void Instance::UpdateRunningFlag()
+{
+    // Handlers may wait for the CPU to pause, while the CPU thread takes this lock from the input callback. The lock is only
+    // held to receive calls and pick the thread that runs them, never while running one.
+    while (true)
+    {
+        DolphinIpcToInstanceData data;
+
+        {
+            std::lock_guard<std::mutex> ipcLock(_ipcReceiveMutex);
+
+            if (IsStepDispatchOnCpuThread())
+            {
+                // The parked CPU thread runs these, or picks them up when the step in flight parks
+                bool isReceived = false;
+
+                while (ipcReceiveFromServer(data))
+                {
+                    _parkedServerCalls.push_back(std::move(data));
+                    isReceived = true;
+                }
+
+                if (isReceived)
+                {
+                    _stepParkCondition.notify_all();
+                }
+                break;
+            }
+
+            // Calls the CPU thread left queued were received first, so they run before anything still in the pipe
+            if (!_parkedServerCalls.empty())
+            {
+                data = std::move(_parkedServerCalls.front());
+                _parkedServerCalls.pop_front();
+            }
+            else if (!ipcReceiveFromServer(data))
+            {
+                break;
+            }
+        }
+
+        onServerToInstanceDataReceived(data);
+    }
+
+    if (_mockServer)
+    {
+        _mockServer->Update();
+    }
+
+    // Close if no heartbeat command sent over IPC recently
+    if (std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now() - _lastHeartbeat) > std::chrono::seconds(15))
     {
         // RequestShutdown();
     }
@@ -560,13 +1822,15 @@ void Instance::UpdateRunningFlag()
     }
 }
 
-void Instance::StartRecording()
+void Instance::StartRecording(int ramHashIntervalFrames)
 {
     if (_instanceState == RecordingState::Recording)
     {
         return;
     }
 
+    _ramHashChecker.StartRecording(ramHashIntervalFrames);
+    _lagFrameTracker.StartRecording();
     _instanceState = RecordingState::Recording;
 }
 
@@ -584,6 +1848,8 @@ void Instance::StopRecording()
     data->_inputRecording[1] = _recordingInputs[1];
     data->_inputRecording[2] = _recordingInputs[2];
     data->_inputRecording[3] = _recordingInputs[3];
+    data->_ramHashes = _ramHashChecker.TakeRecording();
+    data->_lagFrames = _lagFrameTracker.TakeRecording();
     ipcSendToServer(ipcData);
 
     _recordingInputs[0].Clear();
@@ -592,13 +1858,56 @@ void Instance::StopRecording()
     _recordingInputs[3].Clear();
 }
 
-void Instance::OnCommandCompleted(DolphinInstanceIpcCall completedCommand)
+void Instance::OnCommandCompleted(DolphinInstanceIpcCall completedCommand, float emulatedFps)
 {
     CREATE_TO_SERVER_DATA(OnInstanceCommandCompleted, ipcData, data)
     data->_completedCommand = completedCommand;
+    data->_emulatedFps = emulatedFps;
     ipcSendToServer(ipcData);
 }
 
+void Instance::BeginTimedRun(bool turbo)
+{
+    // A new run replaces any turbo run still in flight, keeping the settings from before the first one
+    if (turbo && !_isTurboActive)
+    {
+        _turboPreviousSettings._emulationSpeed = Config::Get(Config::MAIN_EMULATION_SPEED);
+        _turboPreviousSettings._isVSyncEnabled = Config::Get(Config::GFX_VSYNC);
+        _turboPreviousSettings._isAudioMuted = Config::Get(Config::MAIN_AUDIO_MUTED);
+        _turboPreviousSettings._isDumpingFrames = Config::Get(Config::MAIN_MOVIE_DUMP_FRAMES);
+
+        Config::SetCurrent(Config::MAIN_EMULATION_SPEED, 0.0f);
+        Config::SetCurrent(Config::GFX_VSYNC, false);
+        Config::SetCurrent(Config::MAIN_AUDIO_MUTED, true);
+        Config::SetCurrent(Config::MAIN_MOVIE_DUMP_FRAMES, false);
+        _isTurboActive = true;
+    }
+    else if (!turbo && _isTurboActive)
+    {
+        EndTimedRun();
+    }
+
+    _timedRunStartFrame = Movie::GetCurrentFrame();
+    _timedRunStartTime = std::chrono::steady_clock::now();
+}
+
+float Instance::EndTimedRun()
+{
+    if (_isTurboActive)
+    {
+        Config::SetCurrent(Config::MAIN_EMULATION_SPEED, _turboPreviousSettings._emulationSpeed);
+        Config::SetCurrent(Config::GFX_VSYNC, _turboPreviousSettings._isVSyncEnabled);
+        Config::SetCurrent(Config::MAIN_AUDIO_MUTED, _turboPreviousSettings._isAudioMuted);
+        Config::SetCurrent(Config::MAIN_MOVIE_DUMP_FRAMES, _turboPreviousSettings._isDumpingFrames);
+        _isTurboActive = false;
+    }
+
+    std::chrono::duration<float> elapsed = std::chrono::steady_clock::now() - _timedRunStartTime;
+    u64 framesElapsed = Movie::GetCurrentFrame() - _timedRunStartFrame;
+
+    return elapsed.count() > 0.0f ? float(framesElapsed) / elapsed.count() : 0.0f;
+}
+
 void Instance::Log(Common::Log::LogLevel level, const char* text)
 {
     // Intentionally using the same enum values so we can cast like this
@@ -5,15 +5,43 @@
 
 #include "dolphin-ipc/DolphinIpcHandlerBase.h"
 #include "dolphin-ipc/IpcStructs.h"
+#include "dolphin-ipc/SharedPayloadBuffer.h"
+#include "dolphin-ipc/SharedRamView.h"
+
+#include "InputSearch.h"
+#include "LagFrameTracker.h"
+#include "MemoryScanner.h"
+#include "MemoryTriggers.h"
+#include "MemoryWatcher.h"
+#include "PointerScanner.h"
+#include "RamDiffer.h"
+#include "RamHashChecker.h"
+#include "RewindBuffer.h"
+#include "SaveStateStore.h"
+#include "SaveStateWriter.h"
+#include "StateHasher.h"
+#include "StateSlots.h"
+#include "StepObserver.h"
+#include "TasInputQueue.h"
 
 #include "Common/Flag.h"
 #include "Common/Logging/LogManager.h"
 #include "Common/WindowSystemInfo.h"
 #include "Core/Movie.h"
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <limits>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <queue>
+#include <vector>
 
 class InstanceIpcHandler;
 class MockServer;
@@ -83,12 +111,71 @@ protected:
 	INSTANCE_FUNC_OVERRIDE(FormatMemoryCard);
 	INSTANCE_FUNC_OVERRIDE(ReadMemory);
 	INSTANCE_FUNC_OVERRIDE(WriteMemory);
+	INSTANCE_FUNC_OVERRIDE(SubscribeMemoryWatches);
+	INSTANCE_FUNC_OVERRIDE(UnsubscribeMemoryWatches);
+	INSTANCE_FUNC_OVERRIDE(ScanMemory);
+	INSTANCE_FUNC_OVERRIDE(ClearMemoryScan);
+	INSTANCE_FUNC_OVERRIDE(ScanPointerPaths);
+	INSTANCE_FUNC_OVERRIDE(SetSharedRamMapping);
+	INSTANCE_FUNC_OVERRIDE(ReadMemoryTyped);
+	INSTANCE_FUNC_OVERRIDE(WriteMemoryTyped);
+	INSTANCE_FUNC_OVERRIDE(RegisterMemoryTriggers);
+	INSTANCE_FUNC_OVERRIDE(UnregisterMemoryTriggers);
+	INSTANCE_FUNC_OVERRIDE(StartRamDiff);
+	INSTANCE_FUNC_OVERRIDE(StopRamDiff);
+	INSTANCE_FUNC_OVERRIDE(SaveStateToSlot);
+	INSTANCE_FUNC_OVERRIDE(LoadStateFromSlot);
+	INSTANCE_FUNC_OVERRIDE(FreeStateSlots);
+	INSTANCE_FUNC_OVERRIDE(ListStateSlots);
+	INSTANCE_FUNC_OVERRIDE(PersistStateSlot);
+	INSTANCE_FUNC_OVERRIDE(SaveStateToStore);
+	INSTANCE_FUNC_OVERRIDE(LoadStateFromStore);
+	INSTANCE_FUNC_OVERRIDE(CreateSaveStateData);
+	INSTANCE_FUNC_OVERRIDE(LoadSaveStateData);
+	INSTANCE_FUNC_OVERRIDE(ConfigureRewind);
+	INSTANCE_FUNC_OVERRIDE(RewindToFrame);
+	INSTANCE_FUNC_OVERRIDE(FlushMemoryCards);
+	INSTANCE_FUNC_OVERRIDE(ReadMemoryCardImage);
+	INSTANCE_FUNC_OVERRIDE(WriteMemoryCardImage);
+	INSTANCE_FUNC_OVERRIDE(PersistMemoryCard);
+	INSTANCE_FUNC_OVERRIDE(SetStepMode);
+	INSTANCE_FUNC_OVERRIDE(StepFrames);
+	INSTANCE_FUNC_OVERRIDE(ConfigureObservation);
+	INSTANCE_FUNC_OVERRIDE(Step);
+	INSTANCE_FUNC_OVERRIDE(SearchInputs);
+	INSTANCE_FUNC_OVERRIDE(ConfigureStateHash);
+	INSTANCE_FUNC_OVERRIDE(GetStateHash);
+	INSTANCE_FUNC_OVERRIDE(ScheduleCommand);
+	INSTANCE_FUNC_OVERRIDE(ConfigureTasInputQueue);
+	INSTANCE_FUNC_OVERRIDE(QueueTasInputs);
+	INSTANCE_FUNC_OVERRIDE(ClearTasInputQueue);
 
 	void CheckGcFrameAdvance(GCPadStatus* padStatus, int controllerId, bool checkInputs);
+	u64 HoldFrameAdvance();
+	void RebaseFrameAdvance(u64 framesRemaining);
+	void UpdateMemoryWatches();
+	void UpdateMemoryTriggers();
+	void UpdateRamDiff();
+	bool VerifyPlaybackRamHash();
+	void UpdateSharedRam();
+	void RefreshSharedRam();
+	DolphinPayload CreatePayload(std::vector<u8> bytes, const std::string& payloadName, bool useSharedMemory);
+	bool ResolvePayload(const DolphinPayload& payload, std::vector<u8>& outBytes);
 	void UpdateRunningFlag();
-	void StartRecording();
+	void AdvanceInputSearch();
+	void BeginStep(int numFrames, bool returnObservation);
+	void WaitForStepToken();
+	bool IsStepDispatchOnCpuThread() const;
+	void RunWithCpuPaused(const std::function<void()>& job);
+	void RunScheduledCommands();
+	void SendTasInputQueueStatus(bool isLowWater, const int* droppedInputs);
+	static bool CanRunOnCpuThread(DolphinInstanceIpcCall call);
+	static bool ControlsRunState(DolphinInstanceIpcCall call);
+	void StartRecording(int ramHashIntervalFrames = 0);
 	void StopRecording();
-	void OnCommandCompleted(DolphinInstanceIpcCall completedCommand);
+	void OnCommandCompleted(DolphinInstanceIpcCall completedCommand, float emulatedFps = 0.0f);
+	void BeginTimedRun(bool turbo);
+	float EndTimedRun();
 	void Log(Common::Log::LogLevel level, const char* text) override;
 
 	Common::Flag _running{true};
@@ -107,8 +194,41 @@ protected:
 		Playback,
 	};
 
+	std::string _instanceId;
 	int _coreStateEventHandle = -1;
 	int _framesToAdvance = 0;
+	std::atomic<u64> _frameAdvanceEndFrame = 0;
+	bool _frameAdvanceSkipsLagFrames = false;
+	bool _isFirstPollOfFrame = false;		// CPU thread only
+	std::atomic<bool> _isStepModeEnabled = false;
+	std::atomic<int> _stepFramesRemaining = 0;
+	std::atomic<bool> _stepReturnsObservation = false;
+	std::atomic<bool> _isStepUsingTasInput = false;
+	std::mutex _ipcReceiveMutex;
+	std::condition_variable _stepParkCondition;
+	bool _isStepParked = false;									// Guarded by _ipcReceiveMutex
+	std::deque<DolphinIpcToInstanceData> _parkedServerCalls;	// Received while a step is parked or running, in order
+	std::queue<std::packaged_task<void()>> _parkedCpuJobs;		// Host thread work for the parked CPU thread to run
+
+	struct ScheduledCommand
+	{
+		u64 _frameNumber = 0;
+		u64 _sequence = 0;		// Keeps calls due on the same frame in the order they were scheduled
+		u64 _scheduleId = 0;
+		DolphinIpcToInstanceData _command;
+
+		bool operator>(const ScheduledCommand& other) const
+		{
+			return _frameNumber != other._frameNumber ? _frameNumber > other._frameNumber : _sequence > other._sequence;
+		}
+	};
+
+	void ExecuteScheduledCommand(const ScheduledCommand& scheduled, u64 executedFrame);
+
+	std::mutex _scheduleMutex;
+	std::priority_queue<ScheduledCommand, std::vector<ScheduledCommand>, std::greater<ScheduledCommand>> _scheduledCommands;
+	std::atomic<u64> _nextScheduledFrame = std::numeric_limits<u64>::max();	// Lets frames with nothing due skip the lock
+	u64 _scheduleSequence = 0;
 	bool _bootToPause = false;
 	bool _shouldUseHardwareController = true;
 	RecordingState _instanceState = RecordingState::None;
@@ -119,5 +239,42 @@ protected:
 	DolphinControllerState _hardwareInputStates[4];
 	DolphinControllerState _tasInputStates[4];
 
+	InputSearch _inputSearch;
+	LagFrameTracker _lagFrameTracker;
+	MemoryScanner _memoryScanner;
+	MemoryTriggers _memoryTriggers;
+	MemoryWatcher _memoryWatcher;
+	RamDiffer _ramDiffer;
+	RamHashChecker _ramHashChecker;
+	RewindBuffer _rewindBuffer;
+	SaveStateStore _saveStateStore;
+	SaveStateWriter _saveStateWriter;
+	StateSlots _stateSlots;
+	StepObserver _stepObserver;
+	StateHasher _stateHasher;
+	TasInputQueue _tasInputQueue;
+	PointerScanner _pointerScanner;
+
+	std::unique_ptr<SharedRamView> _sharedRamView;
+	int _sharedRamPublishIntervalFrames = 1;
+	u64 _nextSharedRamPublishFrame = 0;
+	float _rewindPreviousEmulationSpeed = 1.0f;
+
+	struct TurboPreviousSettings
+	{
+		float _emulationSpeed = 1.0f;
+		bool _isVSyncEnabled = false;
+		bool _isAudioMuted = false;
+		bool _isDumpingFrames = false;
+	};
+
+	bool _isTurboActive = false;
+	TurboPreviousSettings _turboPreviousSettings;
+	u64 _timedRunStartFrame = 0;
+	std::chrono::steady_clock::time_point _timedRunStartTime;
+
+	std::vector<std::unique_ptr<SharedPayloadBuffer>> _outgoingPayloads;
+	u64 _outgoingPayloadCounter = 0;
+
 	std::shared_ptr<MockServer> _mockServer;
 };
@@ -30,6 +30,7 @@ void InstanceConfigLoader::Load(Config::Layer* config_layer)
     // Use a custom (temp) memory card location, to prevent this instance from conflicting with other running instances
     // If we want to save any memory card data, its up to the user to save a copy of this data (probably via a Server UI => IPC call)
     std::string userRoot = File::GetUserPath(D_USER_IDX) + "../Temp";
+
     config_layer->Set(Config::MAIN_MEMCARD_A_PATH, userRoot + "/" + _memoryCardName + "_A.raw");
     config_layer->Set(Config::MAIN_MEMCARD_B_PATH, userRoot + "/" + _memoryCardName + "_B.raw");
 
@@ -1,5 +1,8 @@
 #include "InstanceUtils.h"
 
+#include "MemoryCardCache.h"
+#include "SimdByteSwap.h"
+
 #include "InputCommon/GCPadStatus.h"
 
 #include "Common/FileUtil.h"
@@ -11,6 +14,8 @@
 #include "Core/HW/GCMemcard/GCMemcardUtils.h"
 #include "Core/HW/Memmap.h"
 
+#include <algorithm>
+#include <iterator>
 #include <variant>
 
 void InstanceUtils::CopyControllerStateToGcPadStatus(const DolphinControllerState& padState, GCPadStatus* padStatus)
@@ -90,7 +95,7 @@ std::string InstanceUtils::GetPathForMemoryCardSlot(DolphinSlot slot)
         }
         case DolphinSlot::SlotB:
         {
-            return Config::Get(Config::MAIN_MEMCARD_A_PATH);
+            return Config::Get(Config::MAIN_MEMCARD_B_PATH);
         }
         default:
         {
@@ -99,6 +104,15 @@ std::string InstanceUtils::GetPathForMemoryCardSlot(DolphinSlot slot)
     }
 }
 
+namespace
+{
+    MemoryCardCache& GetMemoryCardCache()
+    {
+        static MemoryCardCache memoryCardCache;
+        return memoryCardCache;
+    }
+}
+
 bool InstanceUtils::ExportGci(DolphinSlot slot, const std::string& filePath)
 {
     if (filePath.empty())
@@ -106,12 +120,16 @@ bool InstanceUtils::ExportGci(DolphinSlot slot, const std::string& filePath)
         return false;
     }
 
-    if (File::Exists(filePath))
-    {
-        File::Delete(filePath);
-    }
+    std::vector<Memcard::Savefile> savefiles;
+    bool result = CaptureGci(slot, savefiles);
+    WriteGci(savefiles, filePath);
 
-    std::string slotPath = InstanceUtils::GetPathForMemoryCardSlot(DolphinSlot::SlotA);
+    return result;
+}
+
+bool InstanceUtils::CaptureGci(DolphinSlot slot, std::vector<Memcard::Savefile>& outSavefiles)
+{
+    outSavefiles.clear();
 
     // Read the current gamecode from memory
     std::string gameCode =
@@ -124,11 +142,8 @@ bool InstanceUtils::ExportGci(DolphinSlot slot, const std::string& filePath)
         // (char)Memory::Read_U8(0x80000005),
     };
 
-    std::pair<Memcard::GCMemcardErrorCode, std::optional<Memcard::GCMemcard>> memoryCardOpenInfo = Memcard::GCMemcard::Open(slotPath);
-
-    if (memoryCardOpenInfo.second.has_value())
+    return GetMemoryCardCache().Access(slot, [&](Memcard::GCMemcard& memoryCard)
     {
-        Memcard::GCMemcard& memoryCard = memoryCardOpenInfo.second.value();
         const u8 numFiles = memoryCard.GetNumFiles();
         for (int index = 0; index < numFiles; index++)
         {
@@ -140,37 +155,41 @@ bool InstanceUtils::ExportGci(DolphinSlot slot, const std::string& filePath)
                 break;
             }
 
-            const std::vector<Memcard::Savefile> savefiles = Memcard::GetSavefiles(memoryCard, { fileIndex });
+            std::vector<Memcard::Savefile> savefiles = Memcard::GetSavefiles(memoryCard, { fileIndex });
 
             if (savefiles.size() <= 1)
             {
-                if (!Memcard::WriteSavefile(filePath, savefiles[0], Memcard::SavefileFormat::GCI))
-                {
-                    File::Delete(filePath);
-                }
+                outSavefiles.insert(outSavefiles.end(), std::make_move_iterator(savefiles.begin()), std::make_move_iterator(savefiles.end()));
             }
         }
-    }
 
-    return true;
+        return false;
+    });
 }
 
-bool InstanceUtils::ImportGci(DolphinSlot slot, const std::string& filePath)
+void InstanceUtils::WriteGci(const std::vector<Memcard::Savefile>& savefiles, const std::string& filePath)
 {
-    if (filePath.empty())
+    if (File::Exists(filePath))
     {
-        return false;
+        File::Delete(filePath);
     }
 
-    std::string slotPath = InstanceUtils::GetPathForMemoryCardSlot(DolphinSlot::SlotA);
-    std::pair<Memcard::GCMemcardErrorCode, std::optional<Memcard::GCMemcard>> memoryCardOpenInfo = Memcard::GCMemcard::Open(slotPath);
+    for (const Memcard::Savefile& savefile : savefiles)
+    {
+        if (!Memcard::WriteSavefile(filePath, savefile, Memcard::SavefileFormat::GCI))
+        {
+            File::Delete(filePath);
+        }
+    }
+}
 
-    if (!memoryCardOpenInfo.second.has_value())
+bool InstanceUtils::ImportGci(DolphinSlot slot, const std::string& filePath)
+{
+    if (filePath.empty())
     {
         return false;
     }
 
-    Memcard::GCMemcard& memoryCard = memoryCardOpenInfo.second.value();
     std::variant<Memcard::ReadSavefileErrorCode, Memcard::Savefile> readResult = Memcard::ReadSavefile(filePath);
 
     bool result = false;
@@ -179,8 +198,15 @@ bool InstanceUtils::ImportGci(DolphinSlot slot, const std::string& filePath)
     {
         [&](Memcard::Savefile gci)
         {
-            Memcard::GCMemcardImportFileRetVal importResult = memoryCard.ImportFile(gci);
-            result = importResult == Memcard::GCMemcardImportFileRetVal::SUCCESS;
+            // Fails as well if the import could not be written through to the card file
+            const bool isWritten = GetMemoryCardCache().Access(slot, [&](Memcard::GCMemcard& memoryCard)
+            {
+                Memcard::GCMemcardImportFileRetVal importResult = memoryCard.ImportFile(gci);
+                result = importResult == Memcard::GCMemcardImportFileRetVal::SUCCESS;
+                return result;
+            });
+
+            result = result && isWritten;
         },
         [&](Memcard::ReadSavefileErrorCode error_code)
         {
@@ -189,7 +215,7 @@ bool InstanceUtils::ImportGci(DolphinSlot slot, const std::string& filePath)
     },
     std::move(readResult));
 
-    return true;
+    return result;
 }
 
 bool InstanceUtils::FormatMemoryCard(DolphinSlot slot, CardEncoding encoding, CardSize cardSize)
@@ -199,11 +225,6 @@ bool InstanceUtils::FormatMemoryCard(DolphinSlot slot, CardEncoding encoding, Ca
 
     if (!slotPath.empty())
     {
-        if (File::Exists(slotPath))
-        {
-            File::Delete(slotPath);
-        }
-
         u16 size;
         switch (cardSize)
         {
@@ -225,13 +246,53 @@ bool InstanceUtils::FormatMemoryCard(DolphinSlot slot, CardEncoding encoding, Ca
 
         if (memcard)
         {
-            return memcard->Save();
+            return GetMemoryCardCache().Replace(slot, std::move(*memcard));
         }
     }
 
     return false;
 }
 
+bool InstanceUtils::FlushMemoryCards()
+{
+    GetMemoryCardCache().FlushAll();
+
+    return true;
+}
+
+bool InstanceUtils::ReadMemoryCardImage(DolphinSlot slot, std::vector<u8>& outImage)
+{
+    // The raw image on disk must include any change whose write through failed
+    GetMemoryCardCache().Flush(slot);
+
+    File::IOFile file(InstanceUtils::GetPathForMemoryCardSlot(slot), "rb");
+
+    if (!file)
+    {
+        return false;
+    }
+
+    outImage.resize(file.GetSize());
+
+    return file.ReadBytes(outImage.data(), outImage.size());
+}
+
+bool InstanceUtils::WriteMemoryCardImage(DolphinSlot slot, const std::vector<u8>& image)
+{
+    std::string slotPath = InstanceUtils::GetPathForMemoryCardSlot(slot);
+
+    if (slotPath.empty() || image.empty())
+    {
+        return false;
+    }
+
+    GetMemoryCardCache().Invalidate(slot);
+
+    File::IOFile file(slotPath, "wb");
+
+    return file && file.WriteBytes(image.data(), image.size());
+}
+
 u32 InstanceUtils::ResolvePointer(u32 address, std::vector<s32> offsets)
 {
     for (unsigned long long offset : offsets)
@@ -273,6 +334,175 @@ bool InstanceUtils::WriteBytes(u32 address, std::vector<u8> bytes)
     return false;
 }
 
+// Reads big endian elements from emulated memory and returns them in host endianness
+std::vector<u8> InstanceUtils::ReadTypedBytes(u32 address, DolphinValueType valueType, s32 numberOfElements)
+{
+    const size_t elementSize = size_t(GetValueTypeSize(valueType));
+    const size_t numberOfBytes = size_t(std::max(numberOfElements, 0)) * elementSize;
+    std::vector<u8> bytes = std::vector<u8>(numberOfBytes);
+    const u8* pointer = InstanceUtils::GetPointerForRange(address, numberOfBytes);
+
+    if (pointer)
+    {
+        InstanceUtils::CopyByteSwapped(bytes.data(), pointer, size_t(numberOfElements), elementSize);
+    }
+
+    return bytes;
+}
+
+// Writes host endian elements to emulated memory as big endian
+bool InstanceUtils::WriteTypedBytes(u32 address, DolphinValueType valueType, const std::vector<u8>& bytes)
+{
+    const size_t elementSize = size_t(GetValueTypeSize(valueType));
+
+    if (bytes.size() % elementSize != 0)
+    {
+        return false;
+    }
+
+    u8* pointer = InstanceUtils::GetPointerForRange(address, bytes.size());
+
+    if (pointer)
+    {
+        InstanceUtils::CopyByteSwapped(pointer, bytes.data(), bytes.size() / elementSize, elementSize);
+        return true;
+    }
+
+    return false;
+}
+
+// Reads a single big endian value of any supported type, widened to a double for comparisons
+bool InstanceUtils::ReadValue(u32 address, DolphinValueType valueType, double& outValue)
+{
+    const u8* pointer = InstanceUtils::GetPointerForRange(address, size_t(GetValueTypeSize(valueType)));
+
+    if (!pointer)
+    {
+        return false;
+    }
+
+    switch (valueType)
+    {
+        case DolphinValueType::U8:
+        {
+            outValue = double(*pointer);
+            break;
+        }
+        case DolphinValueType::U16:
+        {
+            u16 value;
+            memcpy(&value, pointer, sizeof(value));
+            outValue = double(Common::swap16(value));
+            break;
+        }
+        default:
+        case DolphinValueType::U32:
+        {
+            u32 value;
+            memcpy(&value, pointer, sizeof(value));
+            outValue = double(Common::swap32(value));
+            break;
+        }
+        case DolphinValueType::F32:
+        {
+            u32 raw;
+            float value;
+            memcpy(&raw, pointer, sizeof(raw));
+            raw = Common::swap32(raw);
+            memcpy(&value, &raw, sizeof(value));
+            outValue = double(value);
+            break;
+        }
+        case DolphinValueType::F64:
+        {
+            u64 raw;
+            memcpy(&raw, pointer, sizeof(raw));
+            raw = Common::swap64(raw);
+            memcpy(&outValue, &raw, sizeof(outValue));
+            break;
+        }
+    }
+
+    return true;
+}
+
+bool InstanceUtils::CompareValues(double value, DolphinCompareOperator compareOperator, double operand)
+{
+    switch (compareOperator)
+    {
+        default:
+        case DolphinCompareOperator::Equal: return value == operand;
+        case DolphinCompareOperator::NotEqual: return value != operand;
+        case DolphinCompareOperator::Less: return value < operand;
+        case DolphinCompareOperator::LessEqual: return value <= operand;
+        case DolphinCompareOperator::Greater: return value > operand;
+        case DolphinCompareOperator::GreaterEqual: return value >= operand;
+    }
+}
+
+void InstanceUtils::CopyByteSwapped(u8* destination, const u8* source, size_t numberOfElements, size_t elementSize)
+{
+    size_t index = 0;
+    const size_t numberOfBytes = numberOfElements * elementSize;
+
+    if (elementSize <= 1)
+    {
+        memcpy(destination, source, numberOfBytes);
+        return;
+    }
+
+#ifdef _M_X86_64
+    // 64 bytes per iteration, then finish any remainder with scalar swaps
+    for (; index + 64 <= numberOfBytes; index += 64)
+    {
+        for (size_t lane = 0; lane < 64; lane += 16)
+        {
+            __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + index + lane));
+
+            switch (elementSize)
+            {
+                case 2: value = SimdSwap16(value); break;
+                case 4: value = SimdSwap32(value); break;
+                default: value = SimdSwap64(value); break;
+            }
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + index + lane), value);
+        }
+    }
+#endif
+
+    for (; index < numberOfBytes; index += elementSize)
+    {
+        switch (elementSize)
+        {
+            case 2:
+            {
+                u16 value;
+                memcpy(&value, source + index, sizeof(value));
+                value = Common::swap16(value);
+                memcpy(destination + index, &value, sizeof(value));
+                break;
+            }
+            case 4:
+            {
+                u32 value;
+                memcpy(&value, source + index, sizeof(value));
+                value = Common::swap32(value);
+                memcpy(destination + index, &value, sizeof(value));
+                break;
+            }
+            default:
+            {
+                u64 value;
+                memcpy(&value, source + index, sizeof(value));
+                value = Common::swap64(value);
+                memcpy(destination + index, &value, sizeof(value));
+                break;
+            }
+        }
+    }
+}
+
 u8* InstanceUtils::GetPointerForRange(u32 address, size_t size)
 {
     // Make sure we don't have a range spanning 2 separate banks
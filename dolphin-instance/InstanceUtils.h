@@ -4,6 +4,11 @@
 
 struct GCPadStatus;
 
+namespace Memcard
+{
+struct Savefile;
+}
+
 class InstanceUtils
 {
 public:
@@ -12,14 +17,24 @@ public:
 
 	static std::string GetPathForMemoryCardSlot(DolphinSlot slot);
 	static bool ExportGci(DolphinSlot slot, const std::string& filePath);
+	// ExportGci in two halves: the current game's saves are copied off the card first, and written out whenever convenient
+	static bool CaptureGci(DolphinSlot slot, std::vector<Memcard::Savefile>& outSavefiles);
+	static void WriteGci(const std::vector<Memcard::Savefile>& savefiles, const std::string& filePath);
 	static bool ImportGci(DolphinSlot slot, const std::string& filePath);
 	static bool FormatMemoryCard(DolphinSlot slot, CardEncoding encoding, CardSize cardSize);
+	static bool FlushMemoryCards();
+	static bool ReadMemoryCardImage(DolphinSlot slot, std::vector<u8>& outImage);
+	static bool WriteMemoryCardImage(DolphinSlot slot, const std::vector<u8>& image);
 
 	static u32 ResolvePointer(u32 address, std::vector<s32> offsets);
 	static std::vector<u8> ReadBytes(u32 address, s32 numberOfBytes);
 	static bool WriteBytes(u32 address, std::vector<u8> bytes);
+	static std::vector<u8> ReadTypedBytes(u32 address, DolphinValueType valueType, s32 numberOfElements);
+	static bool WriteTypedBytes(u32 address, DolphinValueType valueType, const std::vector<u8>& bytes);
+	static bool ReadValue(u32 address, DolphinValueType valueType, double& outValue);
+	static bool CompareValues(double value, DolphinCompareOperator compareOperator, double operand);
+	static void CopyByteSwapped(u8* destination, const u8* source, size_t numberOfElements, size_t elementSize);
 
-private:
 	static u8* GetPointerForRange(u32 address, size_t size);
 	static u8* GetPointer(u32 address);
 };
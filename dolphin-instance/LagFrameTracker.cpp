@@ -0,0 +1,86 @@
+#include "LagFrameTracker.h"
+
+#include <utility>
+
+bool LagFrameTracker::OnInputPolled(u64 frameNumber)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    // Games may poll several times in one frame, only the first poll says anything about lag
+    if (_hasPolled && frameNumber == _lastPolledFrame)
+    {
+        return false;
+    }
+
+    if (!_hasPolled)
+    {
+        _sinceLastTake = DolphinLagBitmap();
+        _sinceLastTake.StartFrame = frameNumber;
+    }
+
+    AppendPolledFrame(_sinceLastTake, frameNumber);
+
+    if (_isRecording)
+    {
+        AppendPolledFrame(_recording, frameNumber);
+    }
+
+    _hasPolled = true;
+    _lastPolledFrame = frameNumber;
+
+    return true;
+}
+
+void LagFrameTracker::StartRecording()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    _recording = DolphinLagBitmap();
+    _recording.StartFrame = _hasPolled ? _lastPolledFrame + 1 : 0;
+    _isRecording = true;
+}
+
+DolphinLagBitmap LagFrameTracker::TakeRecording()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    _isRecording = false;
+
+    DolphinLagBitmap recording = std::move(_recording);
+    _recording = DolphinLagBitmap();
+
+    return recording;
+}
+
+DolphinLagBitmap LagFrameTracker::TakeSinceLastTake()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    DolphinLagBitmap bitmap = std::move(_sinceLastTake);
+    _sinceLastTake = DolphinLagBitmap();
+    _sinceLastTake.StartFrame = bitmap.StartFrame + bitmap.FrameCount;
+
+    return bitmap;
+}
+
+// Called with _mutex held
+void LagFrameTracker::AppendPolledFrame(DolphinLagBitmap& bitmap, u64 frameNumber)
+{
+    if (frameNumber < bitmap.StartFrame)
+    {
+        bitmap = DolphinLagBitmap();
+        bitmap.StartFrame = frameNumber;
+    }
+    else if (frameNumber < bitmap.StartFrame + bitmap.FrameCount)
+    {
+        bitmap.Truncate(frameNumber);
+    }
+
+    // Every frame since the previous polled one went by without a poll
+    while (bitmap.StartFrame + bitmap.FrameCount < frameNumber)
+    {
+        bitmap.PushFrame(true);
+    }
+
+    bitmap.PushFrame(false);
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "dolphin-ipc/IpcStructs.h"
+
+#include "Common/CommonTypes.h"
+
+#include <mutex>
+
+// Works out which emulated frames were lag frames from the frames the game polled its controllers on: every frame between
+// two polled frames was skipped by the game's input handling. Bitmaps are kept for the current recording and for the
+// frames since the last heartbeat. Loading an earlier state truncates both back to the frame emulation resumed on.
+class LagFrameTracker
+{
+public:
+	// CPU thread, at the first controller of every poll. Returns true for the first poll of a frame.
+	bool OnInputPolled(u64 frameNumber);
+
+	// Host thread. The recording covers the frames after the last polled one.
+	void StartRecording();
+	DolphinLagBitmap TakeRecording();
+	DolphinLagBitmap TakeSinceLastTake();
+
+private:
+	void AppendPolledFrame(DolphinLagBitmap& bitmap, u64 frameNumber);
+
+	std::mutex _mutex;
+	bool _hasPolled = false;
+	bool _isRecording = false;
+	u64 _lastPolledFrame = 0;
+	DolphinLagBitmap _recording;
+	DolphinLagBitmap _sinceLastTake;
+};
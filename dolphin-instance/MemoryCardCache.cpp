@@ -0,0 +1,131 @@
+#include "MemoryCardCache.h"
+
+#include "InstanceUtils.h"
+
+bool MemoryCardCache::Access(DolphinSlot slot, const std::function<bool(Memcard::GCMemcard& memoryCard)>& operation)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    CachedCard* cachedCard = GetCachedCard(slot);
+
+    if (!cachedCard)
+    {
+        return false;
+    }
+
+    std::string filePath = InstanceUtils::GetPathForMemoryCardSlot(slot);
+
+    // Reparse if the file is not the one that was parsed, for example because the game saved. Changes that failed to write
+    // through are dropped then, the file holds the game's own saves.
+    if (!cachedCard->_memoryCard || cachedCard->_filePath != filePath || cachedCard->_lastWriteTime != GetLastWriteTime(filePath))
+    {
+        cachedCard->_memoryCard = Memcard::GCMemcard::Open(filePath).second;
+        cachedCard->_filePath = filePath;
+        cachedCard->_lastWriteTime = GetLastWriteTime(filePath);
+        cachedCard->_isDirty = false;
+    }
+
+    if (!cachedCard->_memoryCard)
+    {
+        return false;
+    }
+
+    if (operation(cachedCard->_memoryCard.value()))
+    {
+        cachedCard->_isDirty = true;
+        return FlushLocked(*cachedCard);
+    }
+
+    return true;
+}
+
+bool MemoryCardCache::Replace(DolphinSlot slot, Memcard::GCMemcard&& memoryCard)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    CachedCard* cachedCard = GetCachedCard(slot);
+
+    if (!cachedCard)
+    {
+        return false;
+    }
+
+    cachedCard->_memoryCard = std::move(memoryCard);
+    cachedCard->_filePath = InstanceUtils::GetPathForMemoryCardSlot(slot);
+    cachedCard->_lastWriteTime = GetLastWriteTime(cachedCard->_filePath);
+    cachedCard->_isDirty = true;
+
+    return FlushLocked(*cachedCard);
+}
+
+void MemoryCardCache::Invalidate(DolphinSlot slot)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (CachedCard* cachedCard = GetCachedCard(slot))
+    {
+        *cachedCard = CachedCard();
+    }
+}
+
+bool MemoryCardCache::Flush(DolphinSlot slot)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    CachedCard* cachedCard = GetCachedCard(slot);
+
+    return cachedCard && FlushLocked(*cachedCard);
+}
+
+void MemoryCardCache::FlushAll()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    for (CachedCard& cachedCard : _cards)
+    {
+        FlushLocked(cachedCard);
+    }
+}
+
+MemoryCardCache::CachedCard* MemoryCardCache::GetCachedCard(DolphinSlot slot)
+{
+    switch (slot)
+    {
+        case DolphinSlot::SlotA: return &_cards[0];
+        case DolphinSlot::SlotB: return &_cards[1];
+        default: return nullptr;
+    }
+}
+
+bool MemoryCardCache::FlushLocked(CachedCard& cachedCard)
+{
+    if (!cachedCard._isDirty || !cachedCard._memoryCard)
+    {
+        return true;
+    }
+
+    // Never write over saves the game made since the card was parsed, the next access picks those up instead
+    if (cachedCard._lastWriteTime != GetLastWriteTime(cachedCard._filePath))
+    {
+        cachedCard._isDirty = false;
+        return false;
+    }
+
+    if (!cachedCard._memoryCard->Save())
+    {
+        return false;
+    }
+
+    cachedCard._isDirty = false;
+    cachedCard._lastWriteTime = GetLastWriteTime(cachedCard._filePath);
+
+    return true;
+}
+
+std::filesystem::file_time_type MemoryCardCache::GetLastWriteTime(const std::string& filePath)
+{
+    std::error_code errorCode;
+    std::filesystem::file_time_type lastWriteTime = std::filesystem::last_write_time(std::filesystem::u8path(filePath), errorCode);
+
+    return errorCode ? std::filesystem::file_time_type() : lastWriteTime;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "dolphin-ipc/IpcStructs.h"
+
+#include "Core/HW/GCMemcard/GCMemcard.h"
+
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+
+// Keeps each slot's parsed memory card open between operations, instead of re-reading and parsing the raw image every time.
+// Changes made through the cache are written through to the raw file straight away. If the raw file changes underneath the
+// card, for example because the game saved, the card is reparsed on next use.
+class MemoryCardCache
+{
+public:
+	// Runs operation against the slot's card. Return true from operation if it modified the card. Returns false if the card
+	// could not be opened, or a modification could not be written.
+	bool Access(DolphinSlot slot, const std::function<bool(Memcard::GCMemcard& memoryCard)>& operation);
+	bool Replace(DolphinSlot slot, Memcard::GCMemcard&& memoryCard);
+	void Invalidate(DolphinSlot slot);
+	// Retries writes that failed to go through
+	bool Flush(DolphinSlot slot);
+	void FlushAll();
+
+private:
+	struct CachedCard
+	{
+		std::optional<Memcard::GCMemcard> _memoryCard;
+		std::string _filePath;
+		std::filesystem::file_time_type _lastWriteTime;
+		bool _isDirty = false;		// A write through failed, and is retried on Flush
+	};
+
+	CachedCard* GetCachedCard(DolphinSlot slot);
+	bool FlushLocked(CachedCard& cachedCard);
+	static std::filesystem::file_time_type GetLastWriteTime(const std::string& filePath);
+
+	std::mutex _mutex;
+	CachedCard _cards[2];
+};
@@ -0,0 +1,397 @@
+#include "MemoryScanner.h"
+
+#include "InstanceUtils.h"
+#include "SimdByteSwap.h"
+
+#include "Common/Swap.h"
+#include "Core/HW/Memmap.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+namespace
+{
+    constexpr u32 MEM1_BASE_ADDRESS = 0x80000000;
+    constexpr u32 MEM2_BASE_ADDRESS = 0x90000000;
+    constexpr size_t ELEMENTS_PER_WORD = 64;
+
+    bool IsRelativeCompare(DolphinScanCompareType compareType)
+    {
+        return compareType != DolphinScanCompareType::Exact && compareType != DolphinScanCompareType::Range;
+    }
+
+    // Converts the scan operands to T. Returns false when no value of type T can match, rather than letting an out of range
+    // operand wrap around (a u8 range of [0, 300] would otherwise become [0, 44]).
+    template <typename T>
+    bool ToScanOperands(DolphinScanCompareType compareType, double value, double rangeMax, T& outValue, T& outRangeMax)
+    {
+        const double lowest = double(std::numeric_limits<T>::lowest());
+        const double highest = double(std::numeric_limits<T>::max());
+
+        switch (compareType)
+        {
+            case DolphinScanCompareType::Exact:
+            {
+                if (!(value >= lowest && value <= highest) || (std::is_integral_v<T> && value != std::floor(value)))
+                {
+                    return false;
+                }
+
+                outValue = T(value);
+                outRangeMax = outValue;
+                return true;
+            }
+            case DolphinScanCompareType::Range:
+            {
+                const double low = std::max(std::is_integral_v<T> ? std::ceil(value) : value, lowest);
+                const double high = std::min(std::is_integral_v<T> ? std::floor(rangeMax) : rangeMax, highest);
+
+                if (!(low <= high))
+                {
+                    return false;
+                }
+
+                outValue = T(low);
+                outRangeMax = T(high);
+                return true;
+            }
+            default:
+            {
+                // Relative compares have no operands
+                outValue = T();
+                outRangeMax = T();
+                return true;
+            }
+        }
+    }
+
+    template <typename T>
+    T LoadBigEndian(const u8* pointer)
+    {
+        T value;
+        std::memcpy(&value, pointer, sizeof(T));
+        return Common::FromBigEndian(value);
+    }
+
+    template <typename T>
+    u64 MatchBlockScalar(const u8* current, const u8* previous, size_t count, DolphinScanCompareType compareType, T value, T rangeMax)
+    {
+        u64 result = 0;
+
+        for (size_t index = 0; index < count; index++)
+        {
+            const u8* currentElement = current + index * sizeof(T);
+            const u8* previousElement = previous + index * sizeof(T);
+            bool isMatch = false;
+
+            switch (compareType)
+            {
+                case DolphinScanCompareType::Exact: isMatch = LoadBigEndian<T>(currentElement) == value; break;
+                case DolphinScanCompareType::Range:
+                {
+                    T next = LoadBigEndian<T>(currentElement);
+                    isMatch = next >= value && next <= rangeMax;
+                    break;
+                }
+                case DolphinScanCompareType::Changed: isMatch = std::memcmp(currentElement, previousElement, sizeof(T)) != 0; break;
+                case DolphinScanCompareType::Unchanged: isMatch = std::memcmp(currentElement, previousElement, sizeof(T)) == 0; break;
+                case DolphinScanCompareType::Increased: isMatch = LoadBigEndian<T>(currentElement) > LoadBigEndian<T>(previousElement); break;
+                case DolphinScanCompareType::Decreased: isMatch = LoadBigEndian<T>(currentElement) < LoadBigEndian<T>(previousElement); break;
+            }
+
+            result |= u64(isMatch) << index;
+        }
+
+        return result;
+    }
+
+#ifdef _M_X86_64
+    // SSE2 kernels. Values are byte swapped to host order in registers (see SimdByteSwap.h). Unsigned integers are biased by their sign bit so that
+    // the signed SSE2 compares give unsigned ordering. Changed/Unchanged compare raw bits, so NaNs and -0.0 behave as memory does.
+    __m128i LoadRaw(const u8* pointer)
+    {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(pointer));
+    }
+
+    template <typename T>
+    struct ScanVector;
+
+    template <>
+    struct ScanVector<u8>
+    {
+        using Vec = __m128i;
+        static Vec Load(const u8* pointer) { return _mm_xor_si128(LoadRaw(pointer), _mm_set1_epi8(char(0x80))); }
+        static Vec Set(u8 value) { return _mm_set1_epi8(char(value ^ 0x80)); }
+        static Vec Eq(Vec a, Vec b) { return _mm_cmpeq_epi8(a, b); }
+        static Vec Gt(Vec a, Vec b) { return _mm_cmpgt_epi8(a, b); }
+        static Vec Between(Vec value, Vec low, Vec high) { return _mm_andnot_si128(_mm_or_si128(Gt(low, value), Gt(value, high)), _mm_set1_epi32(-1)); }
+        static Vec RawEq(const u8* a, const u8* b) { return _mm_cmpeq_epi8(LoadRaw(a), LoadRaw(b)); }
+        static Vec Not(Vec value) { return _mm_xor_si128(value, _mm_set1_epi32(-1)); }
+        static u32 Mask(Vec value) { return u32(_mm_movemask_epi8(value)); }
+    };
+
+    template <>
+    struct ScanVector<u16>
+    {
+        using Vec = __m128i;
+        static Vec Load(const u8* pointer) { return _mm_xor_si128(SimdSwap16(LoadRaw(pointer)), _mm_set1_epi16(short(0x8000))); }
+        static Vec Set(u16 value) { return _mm_set1_epi16(short(value ^ 0x8000)); }
+        static Vec Eq(Vec a, Vec b) { return _mm_cmpeq_epi16(a, b); }
+        static Vec Gt(Vec a, Vec b) { return _mm_cmpgt_epi16(a, b); }
+        static Vec Between(Vec value, Vec low, Vec high) { return _mm_andnot_si128(_mm_or_si128(Gt(low, value), Gt(value, high)), _mm_set1_epi32(-1)); }
+        static Vec RawEq(const u8* a, const u8* b) { return _mm_cmpeq_epi16(LoadRaw(a), LoadRaw(b)); }
+        static Vec Not(Vec value) { return _mm_xor_si128(value, _mm_set1_epi32(-1)); }
+        static u32 Mask(Vec value) { return u32(_mm_movemask_epi8(_mm_packs_epi16(value, _mm_setzero_si128()))); }
+    };
+
+    template <>
+    struct ScanVector<u32>
+    {
+        using Vec = __m128i;
+        static Vec Load(const u8* pointer) { return _mm_xor_si128(SimdSwap32(LoadRaw(pointer)), _mm_set1_epi32(int(0x80000000))); }
+        static Vec Set(u32 value) { return _mm_set1_epi32(int(value ^ 0x80000000)); }
+        static Vec Eq(Vec a, Vec b) { return _mm_cmpeq_epi32(a, b); }
+        static Vec Gt(Vec a, Vec b) { return _mm_cmpgt_epi32(a, b); }
+        static Vec Between(Vec value, Vec low, Vec high) { return _mm_andnot_si128(_mm_or_si128(Gt(low, value), Gt(value, high)), _mm_set1_epi32(-1)); }
+        static Vec RawEq(const u8* a, const u8* b) { return _mm_cmpeq_epi32(LoadRaw(a), LoadRaw(b)); }
+        static Vec Not(Vec value) { return _mm_xor_si128(value, _mm_set1_epi32(-1)); }
+        static u32 Mask(Vec value) { return u32(_mm_movemask_ps(_mm_castsi128_ps(value))); }
+    };
+
+    template <>
+    struct ScanVector<float>
+    {
+        using Vec = __m128;
+        static Vec Load(const u8* pointer) { return _mm_castsi128_ps(SimdSwap32(LoadRaw(pointer))); }
+        static Vec Set(float value) { return _mm_set1_ps(value); }
+        static Vec Eq(Vec a, Vec b) { return _mm_cmpeq_ps(a, b); }
+        static Vec Gt(Vec a, Vec b) { return _mm_cmpgt_ps(a, b); }
+        static Vec Between(Vec value, Vec low, Vec high) { return _mm_and_ps(_mm_cmpge_ps(value, low), _mm_cmple_ps(value, high)); }
+        static Vec RawEq(const u8* a, const u8* b) { return _mm_castsi128_ps(_mm_cmpeq_epi32(LoadRaw(a), LoadRaw(b))); }
+        static Vec Not(Vec value) { return _mm_xor_ps(value, _mm_castsi128_ps(_mm_set1_epi32(-1))); }
+        static u32 Mask(Vec value) { return u32(_mm_movemask_ps(value)); }
+    };
+
+    template <>
+    struct ScanVector<double>
+    {
+        using Vec = __m128d;
+        static Vec Load(const u8* pointer) { return _mm_castsi128_pd(SimdSwap64(LoadRaw(pointer))); }
+        static Vec Set(double value) { return _mm_set1_pd(value); }
+        static Vec Eq(Vec a, Vec b) { return _mm_cmpeq_pd(a, b); }
+        static Vec Gt(Vec a, Vec b) { return _mm_cmpgt_pd(a, b); }
+        static Vec Between(Vec value, Vec low, Vec high) { return _mm_and_pd(_mm_cmpge_pd(value, low), _mm_cmple_pd(value, high)); }
+        static Vec Not(Vec value) { return _mm_xor_pd(value, _mm_castsi128_pd(_mm_set1_epi32(-1))); }
+        static u32 Mask(Vec value) { return u32(_mm_movemask_pd(value)); }
+
+        static Vec RawEq(const u8* a, const u8* b)
+        {
+            // No 64-bit integer compare in SSE2, so both 32-bit halves must match
+            __m128i equal = _mm_cmpeq_epi32(LoadRaw(a), LoadRaw(b));
+            return _mm_castsi128_pd(_mm_and_si128(equal, _mm_shuffle_epi32(equal, _MM_SHUFFLE(2, 3, 0, 1))));
+        }
+    };
+
+    // Matches a full word (64 elements) of candidates, 16 bytes at a time
+    template <typename T>
+    u64 MatchBlockVector(const u8* current, const u8* previous, DolphinScanCompareType compareType, T value, T rangeMax)
+    {
+        using V = ScanVector<T>;
+        constexpr size_t LANES = 16 / sizeof(T);
+
+        const typename V::Vec low = V::Set(value);
+        const typename V::Vec high = V::Set(rangeMax);
+        u64 result = 0;
+
+        for (size_t bit = 0, offset = 0; bit < ELEMENTS_PER_WORD; bit += LANES, offset += 16)
+        {
+            typename V::Vec matches;
+
+            switch (compareType)
+            {
+                default:
+                case DolphinScanCompareType::Exact: matches = V::Eq(V::Load(current + offset), low); break;
+                case DolphinScanCompareType::Range: matches = V::Between(V::Load(current + offset), low, high); break;
+                case DolphinScanCompareType::Changed: matches = V::Not(V::RawEq(current + offset, previous + offset)); break;
+                case DolphinScanCompareType::Unchanged: matches = V::RawEq(current + offset, previous + offset); break;
+                case DolphinScanCompareType::Increased: matches = V::Gt(V::Load(current + offset), V::Load(previous + offset)); break;
+                case DolphinScanCompareType::Decreased: matches = V::Gt(V::Load(previous + offset), V::Load(current + offset)); break;
+            }
+
+            result |= u64(V::Mask(matches)) << bit;
+        }
+
+        return result;
+    }
+#endif
+}
+
+void MemoryScanner::Scan(DolphinValueType valueType, DolphinScanCompareType compareType, double value, double rangeMax, bool newScan)
+{
+    // Switching types changes the element grid, so the old candidates are meaningless
+    bool isFirstPass = newScan || !_hasScanned || valueType != _valueType;
+
+    if (!UpdateRegions())
+    {
+        isFirstPass = true;
+    }
+
+    for (ScanRegion& region : _regions)
+    {
+        switch (valueType)
+        {
+            case DolphinValueType::U8: ScanRegionPass<u8>(region, compareType, value, rangeMax, isFirstPass); break;
+            case DolphinValueType::U16: ScanRegionPass<u16>(region, compareType, value, rangeMax, isFirstPass); break;
+            default: case DolphinValueType::U32: ScanRegionPass<u32>(region, compareType, value, rangeMax, isFirstPass); break;
+            case DolphinValueType::F32: ScanRegionPass<float>(region, compareType, value, rangeMax, isFirstPass); break;
+            case DolphinValueType::F64: ScanRegionPass<double>(region, compareType, value, rangeMax, isFirstPass); break;
+        }
+    }
+
+    _valueType = valueType;
+    _hasScanned = true;
+}
+
+void MemoryScanner::Clear()
+{
+    // Swap with empty vectors to actually release the RAM snapshots
+    std::vector<ScanRegion>().swap(_regions);
+    _hasScanned = false;
+}
+
+template <typename T>
+void MemoryScanner::ScanRegionPass(ScanRegion& region, DolphinScanCompareType compareType, double scanValue, double scanRangeMax, bool isFirstPass)
+{
+    T value;
+    T rangeMax;
+    const bool canMatch = ToScanOperands<T>(compareType, scanValue, scanRangeMax, value, rangeMax);
+
+    const size_t elementCount = region._size / sizeof(T);
+    const size_t wordCount = (elementCount + ELEMENTS_PER_WORD - 1) / ELEMENTS_PER_WORD;
+
+    if (isFirstPass)
+    {
+        region._candidates.assign(wordCount, ~u64(0));
+
+        if (elementCount % ELEMENTS_PER_WORD != 0)
+        {
+            region._candidates.back() = (u64(1) << (elementCount % ELEMENTS_PER_WORD)) - 1;
+        }
+    }
+
+    if (!canMatch)
+    {
+        std::fill(region._candidates.begin(), region._candidates.end(), 0);
+    }
+    // A relative first pass is an "unknown initial value" scan, which only needs the snapshot below
+    else if (!isFirstPass || !IsRelativeCompare(compareType))
+    {
+        const u8* previous = region._previous.empty() ? region._memory : region._previous.data();
+
+        for (size_t word = 0; word < wordCount; word++)
+        {
+            u64 candidates = region._candidates[word];
+
+            if (candidates == 0)
+            {
+                continue;
+            }
+
+            const size_t firstElement = word * ELEMENTS_PER_WORD;
+            const size_t count = std::min(ELEMENTS_PER_WORD, elementCount - firstElement);
+            const u8* currentBlock = region._memory + firstElement * sizeof(T);
+            const u8* previousBlock = previous + firstElement * sizeof(T);
+            u64 matches;
+
+#ifdef _M_X86_64
+            if (count == ELEMENTS_PER_WORD)
+            {
+                matches = MatchBlockVector<T>(currentBlock, previousBlock, compareType, value, rangeMax);
+            }
+            else
+#endif
+            {
+                matches = MatchBlockScalar<T>(currentBlock, previousBlock, count, compareType, value, rangeMax);
+            }
+
+            region._candidates[word] = candidates & matches;
+        }
+    }
+
+    region._previous.assign(region._memory, region._memory + region._size);
+}
+
+bool MemoryScanner::UpdateRegions()
+{
+    std::vector<std::pair<u32, size_t>> layout = { { MEM1_BASE_ADDRESS, size_t(Memory::GetRamSizeReal()) } };
+
+    if (Memory::m_pEXRAM)
+    {
+        layout.push_back({ MEM2_BASE_ADDRESS, size_t(Memory::GetExRamSizeReal()) });
+    }
+
+    // RAM may be remapped between passes (ie after a reboot), so the pointers are always refreshed
+    bool isLayoutUnchanged = _regions.size() == layout.size();
+
+    for (size_t index = 0; isLayoutUnchanged && index < layout.size(); index++)
+    {
+        isLayoutUnchanged = _regions[index]._baseAddress == layout[index].first && _regions[index]._size == layout[index].second;
+    }
+
+    if (!isLayoutUnchanged)
+    {
+        _regions.clear();
+        _regions.resize(layout.size());
+    }
+
+    for (size_t index = 0; index < layout.size(); index++)
+    {
+        _regions[index]._baseAddress = layout[index].first;
+        _regions[index]._size = layout[index].second;
+        _regions[index]._memory = InstanceUtils::GetPointer(layout[index].first);
+    }
+
+    return isLayoutUnchanged;
+}
+
+u64 MemoryScanner::GetCandidateCount() const
+{
+    u64 count = 0;
+
+    for (const ScanRegion& region : _regions)
+    {
+        for (u64 word : region._candidates)
+        {
+            count += u64(std::popcount(word));
+        }
+    }
+
+    return count;
+}
+
+std::vector<u32> MemoryScanner::GetCandidates(size_t maxResults) const
+{
+    std::vector<u32> addresses;
+    const size_t elementSize = size_t(GetValueTypeSize(_valueType));
+
+    for (const ScanRegion& region : _regions)
+    {
+        for (size_t word = 0; word < region._candidates.size() && addresses.size() < maxResults; word++)
+        {
+            u64 candidates = region._candidates[word];
+
+            while (candidates != 0 && addresses.size() < maxResults)
+            {
+                size_t element = word * ELEMENTS_PER_WORD + size_t(std::countr_zero(candidates));
+                addresses.push_back(region._baseAddress + u32(element * elementSize));
+                candidates &= candidates - 1;
+            }
+        }
+    }
+
+    return addresses;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "dolphin-ipc/IpcStructs.h"
+
+#include "Common/CommonTypes.h"
+
+#include <vector>
+
+// Cheat-search style value scanner that works directly on emulated RAM.
+// Candidates are kept as one bit per naturally aligned element between passes, so only the final list needs to cross IPC.
+// Scans must be run while the CPU thread is paused (ie from Core::RunAsCPUThread).
+class MemoryScanner
+{
+public:
+	void Scan(DolphinValueType valueType, DolphinScanCompareType compareType, double value, double rangeMax, bool newScan);
+	void Clear();
+
+	u64 GetCandidateCount() const;
+	std::vector<u32> GetCandidates(size_t maxResults) const;
+
+private:
+	struct ScanRegion
+	{
+		u32 _baseAddress = 0;
+		const u8* _memory = nullptr;
+		size_t _size = 0;
+		std::vector<u64> _candidates;
+		std::vector<u8> _previous;
+	};
+
+	template <typename T>
+	void ScanRegionPass(ScanRegion& region, DolphinScanCompareType compareType, double scanValue, double scanRangeMax, bool isFirstPass);
+
+	bool UpdateRegions();
+
+	std::vector<ScanRegion> _regions;
+	DolphinValueType _valueType = DolphinValueType::U32;
+	bool _hasScanned = false;
+};
@@ -0,0 +1,88 @@
+#include "MemoryTriggers.h"
+
+#include "InstanceUtils.h"
+
+#include <algorithm>
+
+void MemoryTriggers::Register(const std::vector<DolphinMemoryTrigger>& triggers, bool clearExisting)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (clearExisting)
+    {
+        _triggers.clear();
+    }
+
+    for (const DolphinMemoryTrigger& trigger : triggers)
+    {
+        _triggers.erase(std::remove_if(_triggers.begin(), _triggers.end(), [&](const TriggerState& next) { return next._trigger.Id == trigger.Id; }), _triggers.end());
+
+        TriggerState state;
+        state._trigger = trigger;
+        _triggers.push_back(std::move(state));
+    }
+
+    _triggerCount = _triggers.size();
+}
+
+void MemoryTriggers::Unregister(const std::vector<int>& triggerIds)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (triggerIds.empty())
+    {
+        _triggers.clear();
+    }
+    else
+    {
+        _triggers.erase(std::remove_if(_triggers.begin(), _triggers.end(), [&](const TriggerState& next)
+        {
+            return std::find(triggerIds.begin(), triggerIds.end(), next._trigger.Id) != triggerIds.end();
+        }), _triggers.end());
+    }
+
+    _triggerCount = _triggers.size();
+}
+
+std::vector<int> MemoryTriggers::Evaluate(bool& outShouldPause)
+{
+    std::vector<int> firedTriggerIds;
+    outShouldPause = false;
+
+    if (!HasTriggers())
+    {
+        return firedTriggerIds;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    for (TriggerState& state : _triggers)
+    {
+        const DolphinMemoryTrigger& trigger = state._trigger;
+        u32 address = InstanceUtils::ResolvePointer(trigger.Address, trigger.PointerOffsets);
+        double value = 0.0;
+
+        // An unresolvable pointer chain (ie an object that does not exist yet) never matches
+        bool isMatched = InstanceUtils::ReadValue(address, trigger.ValueType, value) && InstanceUtils::CompareValues(value, trigger.Operator, trigger.Value);
+
+        if (isMatched && !state._wasMatched)
+        {
+            firedTriggerIds.push_back(trigger.Id);
+            outShouldPause |= trigger.PauseOnMatch;
+        }
+
+        state._wasMatched = isMatched;
+    }
+
+    if (!firedTriggerIds.empty())
+    {
+        _triggers.erase(std::remove_if(_triggers.begin(), _triggers.end(), [&](const TriggerState& next)
+        {
+            return next._trigger.RemoveOnMatch && std::find(firedTriggerIds.begin(), firedTriggerIds.end(), next._trigger.Id) != firedTriggerIds.end();
+        }), _triggers.end());
+
+        _triggerCount = _triggers.size();
+    }
+
+    return firedTriggerIds;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "dolphin-ipc/IpcStructs.h"
+
+#include "Common/CommonTypes.h"
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+// Server registered memory conditions, evaluated on the CPU thread at the input poll boundary.
+// Triggers are edge sensitive: they fire on the frame their condition becomes true, not on every frame it stays true.
+class MemoryTriggers
+{
+public:
+	void Register(const std::vector<DolphinMemoryTrigger>& triggers, bool clearExisting);
+	void Unregister(const std::vector<int>& triggerIds);
+	bool HasTriggers() const { return _triggerCount.load(std::memory_order_relaxed) > 0; }
+
+	// Returns the ids of every trigger that fired this frame, and whether any of them requested a pause
+	std::vector<int> Evaluate(bool& outShouldPause);
+
+private:
+	struct TriggerState
+	{
+		DolphinMemoryTrigger _trigger;
+		bool _wasMatched = false;
+	};
+
+	mutable std::mutex _mutex;
+	std::vector<TriggerState> _triggers;
+	std::atomic<size_t> _triggerCount = 0;
+};
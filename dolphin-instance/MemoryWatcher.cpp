@@ -0,0 +1,119 @@
+#include "MemoryWatcher.h"
+
+#include "InstanceUtils.h"
+
+#include <algorithm>
+#include <cstring>
+
+void MemoryWatcher::Subscribe(const std::vector<DolphinMemoryWatch>& watches, int sampleIntervalFrames, bool clearExisting)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (clearExisting)
+    {
+        _watches.clear();
+    }
+
+    for (const DolphinMemoryWatch& watch : watches)
+    {
+        if (watch.NumberOfBytes <= 0)
+        {
+            continue;
+        }
+
+        // Re-subscribing an existing id replaces it, and forces a fresh push on the next sample
+        _watches.erase(std::remove_if(_watches.begin(), _watches.end(), [&](const WatchState& next) { return next._watch.Id == watch.Id; }), _watches.end());
+
+        WatchState state;
+        state._watch = watch;
+        state._sampleIntervalFrames = std::max(sampleIntervalFrames, 1);
+        _watches.push_back(std::move(state));
+    }
+
+    _watchCount = _watches.size();
+}
+
+void MemoryWatcher::Unsubscribe(const std::vector<int>& watchIds)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (watchIds.empty())
+    {
+        _watches.clear();
+    }
+    else
+    {
+        _watches.erase(std::remove_if(_watches.begin(), _watches.end(), [&](const WatchState& next)
+        {
+            return std::find(watchIds.begin(), watchIds.end(), next._watch.Id) != watchIds.end();
+        }), _watches.end());
+    }
+
+    _watchCount = _watches.size();
+}
+
+std::vector<DolphinMemoryWatchChange> MemoryWatcher::Sample(u64 frameNumber)
+{
+    std::vector<DolphinMemoryWatchChange> changes;
+
+    if (!HasWatches())
+    {
+        return changes;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    for (WatchState& state : _watches)
+    {
+        if (state._hasSampled && frameNumber < state._nextSampleFrame)
+        {
+            continue;
+        }
+
+        state._nextSampleFrame = frameNumber + u64(state._sampleIntervalFrames);
+
+        u32 address = InstanceUtils::ResolvePointer(state._watch.Address, state._watch.PointerOffsets);
+        size_t size = size_t(state._watch.NumberOfBytes);
+        const u8* pointer = InstanceUtils::GetPointerForRange(address, size);
+
+        // Compare in place against emulated RAM, so unchanged regions never allocate or copy
+        bool changed = !state._hasSampled || address != state._lastAddress;
+
+        if (!changed)
+        {
+            if (pointer)
+            {
+                changed = state._lastBytes.size() != size || std::memcmp(state._lastBytes.data(), pointer, size) != 0;
+            }
+            else
+            {
+                changed = !state._lastBytes.empty();
+            }
+        }
+
+        if (!changed)
+        {
+            continue;
+        }
+
+        if (pointer)
+        {
+            state._lastBytes.assign(pointer, pointer + size);
+        }
+        else
+        {
+            state._lastBytes.clear();
+        }
+
+        state._hasSampled = true;
+        state._lastAddress = address;
+
+        DolphinMemoryWatchChange change;
+        change.Id = state._watch.Id;
+        change.ResolvedAddress = address;
+        change.Bytes = state._lastBytes;
+        changes.push_back(std::move(change));
+    }
+
+    return changes;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "dolphin-ipc/IpcStructs.h"
+
+#include "Common/CommonTypes.h"
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+// Tracks server subscribed memory regions, and reports only the regions whose bytes changed since the last push.
+// Subscriptions are made from the host thread, while sampling happens on the CPU thread at the input poll boundary.
+class MemoryWatcher
+{
+public:
+	void Subscribe(const std::vector<DolphinMemoryWatch>& watches, int sampleIntervalFrames, bool clearExisting);
+	void Unsubscribe(const std::vector<int>& watchIds);
+	bool HasWatches() const { return _watchCount.load(std::memory_order_relaxed) > 0; }
+
+	std::vector<DolphinMemoryWatchChange> Sample(u64 frameNumber);
+
+private:
+	struct WatchState
+	{
+		DolphinMemoryWatch _watch;
+		int _sampleIntervalFrames = 1;
+		u64 _nextSampleFrame = 0;
+		bool _hasSampled = false;
+		u32 _lastAddress = 0;
+		std::vector<u8> _lastBytes;
+	};
+
+	mutable std::mutex _mutex;
+	std::vector<WatchState> _watches;
+	std::atomic<size_t> _watchCount = 0;
+};
@@ -0,0 +1,234 @@
+#include "PointerScanner.h"
+
+#include "InstanceUtils.h"
+
+#include "Common/Swap.h"
+#include "Core/HW/Memmap.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    constexpr u32 MEM1_BASE_ADDRESS = 0x80000000;
+    constexpr u32 MEM2_BASE_ADDRESS = 0x90000000;
+    constexpr u32 OS_ARENA_LO_ADDRESS = 0x80000030;
+
+    // Breadth first expansion continues until there is enough independent work to keep every worker busy
+    constexpr size_t WORK_ITEMS_PER_THREAD = 16;
+}
+
+PointerScanner::~PointerScanner()
+{
+    if (_thread.joinable())
+    {
+        _thread.join();
+    }
+}
+
+void PointerScanner::CaptureSnapshot()
+{
+    _regions.clear();
+
+    const u8* ram = InstanceUtils::GetPointer(MEM1_BASE_ADDRESS);
+    _regions.push_back({ MEM1_BASE_ADDRESS, std::vector<u8>(ram, ram + Memory::GetRamSizeReal()) });
+
+    if (Memory::m_pEXRAM)
+    {
+        const u8* exRam = InstanceUtils::GetPointer(MEM2_BASE_ADDRESS);
+        _regions.push_back({ MEM2_BASE_ADDRESS, std::vector<u8>(exRam, exRam + Memory::GetExRamSizeReal()) });
+    }
+
+    // Every aligned word that looks like a pointer into RAM, sorted by the address it points at
+    _reversePointerMap.clear();
+
+    for (const SnapshotRegion& region : _regions)
+    {
+        for (size_t offset = 0; offset + sizeof(u32) <= region._bytes.size(); offset += sizeof(u32))
+        {
+            u32 value;
+            std::memcpy(&value, region._bytes.data() + offset, sizeof(value));
+            value = Common::swap32(value);
+
+            if (IsValidPointer(value))
+            {
+                _reversePointerMap.push_back({ value, region._baseAddress + u32(offset) });
+            }
+        }
+    }
+
+    std::sort(_reversePointerMap.begin(), _reversePointerMap.end(), [](const PointerEntry& a, const PointerEntry& b)
+    {
+        return a._value < b._value || (a._value == b._value && a._location < b._location);
+    });
+}
+
+bool PointerScanner::Start(const PointerScanParameters& parameters, std::function<void(std::vector<DolphinPointerPath> paths, bool truncated)> onComplete)
+{
+    if (_isRunning)
+    {
+        return false;
+    }
+
+    if (_thread.joinable())
+    {
+        _thread.join();
+    }
+
+    PointerScanParameters resolvedParameters = parameters;
+
+    // Default the static range to the game's code and data, which ends where the OS arena begins
+    if (resolvedParameters.staticRangeEnd == 0)
+    {
+        u32 arenaLo = 0;
+
+        if (!_regions.empty() && _regions[0]._bytes.size() > OS_ARENA_LO_ADDRESS - MEM1_BASE_ADDRESS + sizeof(u32))
+        {
+            std::memcpy(&arenaLo, _regions[0]._bytes.data() + (OS_ARENA_LO_ADDRESS - MEM1_BASE_ADDRESS), sizeof(arenaLo));
+            arenaLo = Common::swap32(arenaLo);
+        }
+
+        resolvedParameters.staticRangeEnd = IsValidPointer(arenaLo) ? arenaLo : MEM1_BASE_ADDRESS + Memory::GetRamSizeReal();
+    }
+
+    _isRunning = true;
+    _thread = std::thread([this, resolvedParameters, onComplete]
+    {
+        std::vector<DolphinPointerPath> paths;
+        bool truncated = false;
+
+        Search(resolvedParameters, paths, truncated);
+
+        _isRunning = false;
+        onComplete(std::move(paths), truncated);
+    });
+
+    return true;
+}
+
+void PointerScanner::Search(const PointerScanParameters& parameters, std::vector<DolphinPointerPath>& paths, bool& truncated)
+{
+    _isFull = false;
+    _resultCount = 0;
+
+    if (parameters.maxDepth <= 0 || parameters.maxResults == 0)
+    {
+        return;
+    }
+
+    const size_t threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    std::vector<SearchNode> frontier = { { parameters.targetAddress, {} } };
+
+    // Expand the first levels breadth first, so the rest of the search splits into independent subtrees
+    while (!frontier.empty() && frontier.size() < threadCount * WORK_ITEMS_PER_THREAD && !_isFull)
+    {
+        std::vector<SearchNode> nextFrontier;
+
+        for (const SearchNode& node : frontier)
+        {
+            ExpandNode(node, parameters, &nextFrontier, paths);
+        }
+
+        frontier = std::move(nextFrontier);
+    }
+
+    std::mutex pathsMutex;
+    std::atomic<size_t> nextWorkItem = 0;
+    std::vector<std::thread> workers;
+
+    for (size_t threadIndex = 0; threadIndex < threadCount; threadIndex++)
+    {
+        workers.emplace_back([&]
+        {
+            std::vector<DolphinPointerPath> localPaths;
+
+            for (size_t index = nextWorkItem++; index < frontier.size() && !_isFull; index = nextWorkItem++)
+            {
+                // Depth first from here keeps memory bounded by the chain length rather than the tree width
+                ExpandNode(frontier[index], parameters, nullptr, localPaths);
+            }
+
+            std::lock_guard<std::mutex> lock(pathsMutex);
+            paths.insert(paths.end(), std::make_move_iterator(localPaths.begin()), std::make_move_iterator(localPaths.end()));
+        });
+    }
+
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+
+    truncated = _isFull;
+
+    if (paths.size() > parameters.maxResults)
+    {
+        paths.resize(parameters.maxResults);
+    }
+
+    // Workers finish in any order, so sort for stable output. Shorter chains first, since those are usually the most robust.
+    std::sort(paths.begin(), paths.end(), [](const DolphinPointerPath& a, const DolphinPointerPath& b)
+    {
+        if (a.PointerOffsets.size() != b.PointerOffsets.size())
+        {
+            return a.PointerOffsets.size() < b.PointerOffsets.size();
+        }
+
+        return a.BaseAddress != b.BaseAddress ? a.BaseAddress < b.BaseAddress : a.PointerOffsets < b.PointerOffsets;
+    });
+}
+
+void PointerScanner::ExpandNode(const SearchNode& node, const PointerScanParameters& parameters, std::vector<SearchNode>* children, std::vector<DolphinPointerPath>& paths)
+{
+    if (node._offsets.size() >= size_t(parameters.maxDepth))
+    {
+        return;
+    }
+
+    // Find every pointer p where node address - max offset <= p <= node address
+    const u32 lowest = node._address >= parameters.maxOffset ? node._address - parameters.maxOffset : 0;
+    auto next = std::lower_bound(_reversePointerMap.begin(), _reversePointerMap.end(), lowest, [](const PointerEntry& entry, u32 value)
+    {
+        return entry._value < value;
+    });
+
+    for (; next != _reversePointerMap.end() && next->_value <= node._address && !_isFull; ++next)
+    {
+        SearchNode child;
+        child._address = next->_location;
+        child._offsets.reserve(node._offsets.size() + 1);
+        child._offsets.push_back(s32(node._address - next->_value));
+        child._offsets.insert(child._offsets.end(), node._offsets.begin(), node._offsets.end());
+
+        if (child._address >= parameters.staticRangeStart && child._address < parameters.staticRangeEnd)
+        {
+            if (++_resultCount > parameters.maxResults)
+            {
+                _isFull = true;
+                return;
+            }
+
+            DolphinPointerPath path;
+            path.BaseAddress = child._address;
+            path.PointerOffsets = std::move(child._offsets);
+            paths.push_back(std::move(path));
+        }
+        else if (children)
+        {
+            children->push_back(std::move(child));
+        }
+        else
+        {
+            ExpandNode(child, parameters, nullptr, paths);
+        }
+    }
+}
+
+bool PointerScanner::IsValidPointer(u32 value) const
+{
+    if (value >= MEM1_BASE_ADDRESS && value < MEM1_BASE_ADDRESS + Memory::GetRamSizeReal())
+    {
+        return true;
+    }
+
+    return _regions.size() > 1 && value >= MEM2_BASE_ADDRESS && value < MEM2_BASE_ADDRESS + Memory::GetExRamSizeReal();
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "dolphin-ipc/IpcStructs.h"
+
+#include "Common/CommonTypes.h"
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct PointerScanParameters
+{
+	u32 targetAddress = 0;
+	int maxDepth = 4;
+	u32 maxOffset = 0x1000;
+	u32 staticRangeStart = 0;
+	u32 staticRangeEnd = 0;
+	size_t maxResults = 10000;
+};
+
+// Searches for static base addresses plus offset chains that resolve to a target address.
+// The scan runs on a snapshot of RAM, so only the capture needs the CPU thread paused. The search itself runs in the background.
+class PointerScanner
+{
+public:
+	~PointerScanner();
+
+	bool IsRunning() const { return _isRunning; }
+
+	// Copies MEM1/MEM2 and builds the reverse pointer map. Must be called with the CPU thread paused.
+	void CaptureSnapshot();
+
+	// Searches the captured snapshot on a worker pool, then invokes onComplete from the background thread
+	bool Start(const PointerScanParameters& parameters, std::function<void(std::vector<DolphinPointerPath> paths, bool truncated)> onComplete);
+
+private:
+	struct PointerEntry
+	{
+		u32 _value;
+		u32 _location;
+	};
+
+	struct SearchNode
+	{
+		u32 _address;
+		std::vector<s32> _offsets;
+	};
+
+	struct SnapshotRegion
+	{
+		u32 _baseAddress;
+		std::vector<u8> _bytes;
+	};
+
+	void Search(const PointerScanParameters& parameters, std::vector<DolphinPointerPath>& paths, bool& truncated);
+	void ExpandNode(const SearchNode& node, const PointerScanParameters& parameters, std::vector<SearchNode>* children, std::vector<DolphinPointerPath>& paths);
+	bool IsValidPointer(u32 value) const;
+
+	std::vector<SnapshotRegion> _regions;
+	std::vector<PointerEntry> _reversePointerMap;
+
+	std::thread _thread;
+	std::atomic<bool> _isRunning = false;
+	std::atomic<bool> _isFull = false;
+	std::atomic<size_t> _resultCount = 0;
+};
@@ -0,0 +1,142 @@
+#include "RamDiffer.h"
+
+#include "InstanceUtils.h"
+
+#include "Common/Intrinsics.h"
+#include "Core/HW/Memmap.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    constexpr u32 MEM1_BASE_ADDRESS = 0x80000000;
+    constexpr u32 MEM2_BASE_ADDRESS = 0x90000000;
+
+    bool IsBlockChanged(const u8* current, const u8* snapshot, size_t size)
+    {
+#ifdef _M_X86_64
+        // Accumulate the xor of the whole block and test once, which keeps the loop free of branches
+        __m128i difference = _mm_setzero_si128();
+
+        for (size_t offset = 0; offset < size; offset += 16)
+        {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(current + offset));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(snapshot + offset));
+            difference = _mm_or_si128(difference, _mm_xor_si128(a, b));
+        }
+
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(difference, _mm_setzero_si128())) != 0xFFFF;
+#else
+        return std::memcmp(current, snapshot, size) != 0;
+#endif
+    }
+}
+
+void RamDiffer::Start(int numFrames, int blockSize, bool includeBytes)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    _snapshot.clear();
+    _framesRemaining = std::max(numFrames, 0);
+    _isContinuous = numFrames <= 0;
+    _blockSize = size_t((std::max(blockSize, 16) + 15) / 16 * 16);
+    _includeBytes = includeBytes;
+    _isActive = true;
+}
+
+void RamDiffer::Stop()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    _isActive = false;
+    std::vector<SnapshotRegion>().swap(_snapshot);
+}
+
+bool RamDiffer::Update(u64 frameNumber, std::vector<DolphinRamSpan>& outSpans, u64& outFromFrame)
+{
+    if (!IsActive())
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (_snapshot.empty())
+    {
+        const u8* ram = InstanceUtils::GetPointer(MEM1_BASE_ADDRESS);
+        _snapshot.push_back({ MEM1_BASE_ADDRESS, std::vector<u8>(ram, ram + Memory::GetRamSizeReal()) });
+
+        if (Memory::m_pEXRAM)
+        {
+            const u8* exRam = InstanceUtils::GetPointer(MEM2_BASE_ADDRESS);
+            _snapshot.push_back({ MEM2_BASE_ADDRESS, std::vector<u8>(exRam, exRam + Memory::GetExRamSizeReal()) });
+        }
+
+        _snapshotFrame = frameNumber;
+        return false;
+    }
+
+    outSpans.clear();
+
+    for (SnapshotRegion& region : _snapshot)
+    {
+        DiffRegion(region._baseAddress, InstanceUtils::GetPointer(region._baseAddress), region._bytes.data(), region._bytes.size(), _blockSize, _includeBytes, outSpans);
+    }
+
+    outFromFrame = _snapshotFrame;
+    _snapshotFrame = frameNumber;
+
+    if (!_isContinuous && --_framesRemaining <= 0)
+    {
+        _isActive = false;
+        std::vector<SnapshotRegion>().swap(_snapshot);
+    }
+
+    return true;
+}
+
+void RamDiffer::DiffRegion(u32 baseAddress, const u8* current, u8* snapshot, size_t size, size_t blockSize, bool includeBytes, std::vector<DolphinRamSpan>& outSpans)
+{
+    auto emitSpan = [&](size_t spanStart, size_t spanEnd)
+    {
+        DolphinRamSpan span;
+        span.Address = baseAddress + u32(spanStart);
+        span.Size = u32(spanEnd - spanStart);
+
+        if (includeBytes)
+        {
+            span.Bytes.assign(current + spanStart, current + spanEnd);
+        }
+
+        std::memcpy(snapshot + spanStart, current + spanStart, spanEnd - spanStart);
+        outSpans.push_back(std::move(span));
+    };
+
+    size_t spanStart = 0;
+    bool isInSpan = false;
+
+    // Adjacent changed blocks are merged into a single span
+    for (size_t offset = 0; offset < size; offset += blockSize)
+    {
+        const size_t thisBlockSize = std::min(blockSize, size - offset);
+        const bool isChanged = thisBlockSize == blockSize ? IsBlockChanged(current + offset, snapshot + offset, blockSize)
+            : std::memcmp(current + offset, snapshot + offset, thisBlockSize) != 0;
+
+        if (isChanged && !isInSpan)
+        {
+            spanStart = offset;
+            isInSpan = true;
+        }
+        else if (!isChanged && isInSpan)
+        {
+            emitSpan(spanStart, offset);
+            isInSpan = false;
+        }
+    }
+
+    if (isInSpan)
+    {
+        emitSpan(spanStart, size);
+    }
+}
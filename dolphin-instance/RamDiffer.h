@@ -0,0 +1,41 @@
+#pragma once
+
+#include "dolphin-ipc/IpcStructs.h"
+
+#include "Common/CommonTypes.h"
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+// Reports which spans of MEM1/MEM2 changed between consecutive frame boundaries.
+// The first boundary after Start takes a snapshot, and every following boundary diffs against it. Changed blocks are copied
+// back into the snapshot as they are found, so the snapshot never needs a full re-copy.
+class RamDiffer
+{
+public:
+	void Start(int numFrames, int blockSize, bool includeBytes);
+	void Stop();
+	bool IsActive() const { return _isActive.load(std::memory_order_relaxed); }
+
+	// Called on the CPU thread at the input poll boundary. Returns true if a diff was produced.
+	bool Update(u64 frameNumber, std::vector<DolphinRamSpan>& outSpans, u64& outFromFrame);
+
+	static void DiffRegion(u32 baseAddress, const u8* current, u8* snapshot, size_t size, size_t blockSize, bool includeBytes, std::vector<DolphinRamSpan>& outSpans);
+
+private:
+	struct SnapshotRegion
+	{
+		u32 _baseAddress = 0;
+		std::vector<u8> _bytes;
+	};
+
+	std::mutex _mutex;
+	std::atomic<bool> _isActive = false;
+	std::vector<SnapshotRegion> _snapshot;
+	u64 _snapshotFrame = 0;
+	int _framesRemaining = 0;
+	bool _isContinuous = false;
+	size_t _blockSize = 32;
+	bool _includeBytes = true;
+};
@@ -0,0 +1,106 @@
+#include "RamHashChecker.h"
+
+#include "Core/HW/Memmap.h"
+
+#include <xxhash.h>
+
+#include <algorithm>
+#include <utility>
+
+u64 RamHashChecker::HashRam()
+{
+    // XXH3 picks the widest vector unit available, which keeps a full MEM1 pass well under a millisecond
+    XXH3_state_t* state = XXH3_createState();
+    XXH3_64bits_reset(state);
+    XXH3_64bits_update(state, Memory::m_pRAM, Memory::GetRamSizeReal());
+
+    if (Memory::m_pEXRAM)
+    {
+        XXH3_64bits_update(state, Memory::m_pEXRAM, Memory::GetExRamSizeReal());
+    }
+
+    u64 hash = XXH3_64bits_digest(state);
+    XXH3_freeState(state);
+
+    return hash;
+}
+
+void RamHashChecker::StartRecording(int intervalFrames)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    _recording = DolphinRamHashTrack();
+    _recording.IntervalFrames = std::max(intervalFrames, 0);
+    _recordingPollIndex = 0;
+}
+
+DolphinRamHashTrack RamHashChecker::TakeRecording()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    DolphinRamHashTrack recording = std::move(_recording);
+    _recording = DolphinRamHashTrack();
+
+    return recording;
+}
+
+void RamHashChecker::StartPlayback(DolphinRamHashTrack track)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    _playback = std::move(track);
+    _playbackPollIndex = 0;
+}
+
+void RamHashChecker::RecordPoll()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (_recording.IntervalFrames <= 0)
+    {
+        return;
+    }
+
+    if (_recordingPollIndex++ % u64(_recording.IntervalFrames) == 0)
+    {
+        _recording.Hashes.push_back(HashRam());
+    }
+}
+
+bool RamHashChecker::VerifyPoll(u64& outPollIndex, u64& outExpectedHash, u64& outActualHash)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (_playback.IntervalFrames <= 0 || _playback.Hashes.empty())
+    {
+        return true;
+    }
+
+    const u64 pollIndex = _playbackPollIndex++;
+
+    if (pollIndex % u64(_playback.IntervalFrames) != 0)
+    {
+        return true;
+    }
+
+    const u64 hashIndex = pollIndex / u64(_playback.IntervalFrames);
+
+    if (hashIndex >= _playback.Hashes.size())
+    {
+        return true;
+    }
+
+    const u64 actualHash = HashRam();
+
+    if (actualHash == _playback.Hashes[hashIndex])
+    {
+        return true;
+    }
+
+    outPollIndex = pollIndex;
+    outExpectedHash = _playback.Hashes[hashIndex];
+    outActualHash = actualHash;
+    _playback = DolphinRamHashTrack();
+
+    return false;
+}
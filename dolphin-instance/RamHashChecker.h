@@ -0,0 +1,32 @@
+#pragma once
+
+#include "dolphin-ipc/IpcStructs.h"
+
+#include "Common/CommonTypes.h"
+
+#include <mutex>
+
+// Hashes MEM1/MEM2 every few input polls while recording, and checks the same polls against those hashes during playback.
+// Polls are counted from the start of the recording or playback, so both sides line up when started from the same state.
+class RamHashChecker
+{
+public:
+	static u64 HashRam();
+
+	// Host thread
+	void StartRecording(int intervalFrames);
+	DolphinRamHashTrack TakeRecording();
+	void StartPlayback(DolphinRamHashTrack track);
+
+	// CPU thread, once per input poll
+	void RecordPoll();
+	// Returns false on the first mismatch, after which playback verification stops
+	bool VerifyPoll(u64& outPollIndex, u64& outExpectedHash, u64& outActualHash);
+
+private:
+	std::mutex _mutex;
+	DolphinRamHashTrack _recording;
+	DolphinRamHashTrack _playback;
+	u64 _recordingPollIndex = 0;
+	u64 _playbackPollIndex = 0;
+};
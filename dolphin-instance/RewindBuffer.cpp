@@ -0,0 +1,208 @@
+#include "RewindBuffer.h"
+
+#include "Core/Core.h"
+#include "Core/Movie.h"
+#include "Core/State.h"
+
+#include <zstd.h>
+
+#include <algorithm>
+
+namespace
+{
+    constexpr int COMPRESSION_LEVEL = 1;
+}
+
+void RewindBuffer::Configure(int intervalFrames, int maxCheckpoints)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    _checkpoints.clear();
+    _inputs.clear();
+    _firstInputPollIndex = _pollIndex;
+    _timeline++;
+    _isCapturePending = false;
+    _intervalFrames = std::max(intervalFrames, 1);
+    _maxCheckpoints = size_t(std::max(maxCheckpoints, 0));
+    _isEnabled = intervalFrames > 0 && maxCheckpoints > 0;
+}
+
+bool RewindBuffer::RecordInput(int controllerId, const GCPadStatus& padStatus, u64 frameNumber)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    _currentPadStatuses[controllerId] = padStatus;
+
+    if (controllerId != LAST_CONTROLLER)
+    {
+        return false;
+    }
+
+    PolledInput polledInput;
+    polledInput._frameNumber = frameNumber;
+    std::copy(std::begin(_currentPadStatuses), std::end(_currentPadStatuses), polledInput._padStatuses);
+    _inputs.push_back(polledInput);
+    _pollIndex++;
+
+    const bool isCheckpointDue = !_isCapturePending && (_checkpoints.empty() || frameNumber >= _checkpoints.back()._frameNumber + u64(_intervalFrames));
+
+    if (isCheckpointDue)
+    {
+        _isCapturePending = true;
+    }
+
+    return isCheckpointDue;
+}
+
+bool RewindBuffer::ReplayInput(int controllerId, GCPadStatus& outPadStatus)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    const size_t inputIndex = size_t(_pollIndex - _firstInputPollIndex);
+
+    if (inputIndex >= _inputs.size())
+    {
+        FinishReplay(inputIndex);
+        return true;
+    }
+
+    outPadStatus = _inputs[inputIndex]._padStatuses[controllerId];
+
+    if (controllerId != LAST_CONTROLLER)
+    {
+        return false;
+    }
+
+    _pollIndex++;
+
+    if (_inputs[inputIndex]._frameNumber >= _replayTargetFrame)
+    {
+        FinishReplay(inputIndex + 1);
+        return true;
+    }
+
+    return false;
+}
+
+void RewindBuffer::FinishReplay(size_t replayedInputCount)
+{
+    // The original timeline past the target is abandoned, the next inputs recorded replace it
+    _inputs.resize(std::min(replayedInputCount, _inputs.size()));
+    _isReplaying = false;
+}
+
+void RewindBuffer::CaptureCheckpoint(const std::function<void(const std::function<void()>&)>& runWithCpuPaused)
+{
+    Checkpoint checkpoint;
+    std::vector<u8> state;
+
+    // Capture with the CPU paused, so that the poll index matches the captured state exactly
+    runWithCpuPaused([&]
+    {
+        State::SaveToBuffer(state);
+        checkpoint._frameNumber = Movie::GetCurrentFrame();
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        checkpoint._pollIndex = _pollIndex;
+        checkpoint._timeline = _timeline;
+    });
+
+    checkpoint._stateSize = state.size();
+    checkpoint._compressedState.resize(ZSTD_compressBound(state.size()));
+    size_t compressedSize = ZSTD_compress(checkpoint._compressedState.data(), checkpoint._compressedState.size(), state.data(), state.size(), COMPRESSION_LEVEL);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    _isCapturePending = false;
+
+    if (!IsEnabled() || IsReplaying() || ZSTD_isError(compressedSize) || checkpoint._timeline != _timeline)
+    {
+        return;
+    }
+
+    checkpoint._compressedState.resize(compressedSize);
+    checkpoint._compressedState.shrink_to_fit();
+    _checkpoints.push_back(std::move(checkpoint));
+
+    while (_checkpoints.size() > _maxCheckpoints)
+    {
+        _checkpoints.pop_front();
+    }
+
+    // Inputs from before the oldest checkpoint can never be replayed
+    while (_firstInputPollIndex < _checkpoints.front()._pollIndex && !_inputs.empty())
+    {
+        _inputs.pop_front();
+        _firstInputPollIndex++;
+    }
+}
+
+bool RewindBuffer::BeginRewind(u64 targetFrame)
+{
+    std::vector<u8> compressedState;
+    size_t stateSize = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        auto checkpoint = std::find_if(_checkpoints.rbegin(), _checkpoints.rend(), [&](const Checkpoint& checkpoint)
+        {
+            return checkpoint._frameNumber <= targetFrame;
+        });
+
+        if (IsReplaying() || checkpoint == _checkpoints.rend())
+        {
+            return false;
+        }
+
+        compressedState = checkpoint->_compressedState;
+        stateSize = checkpoint->_stateSize;
+    }
+
+    std::vector<u8> state(stateSize);
+    size_t decompressedSize = ZSTD_decompress(state.data(), state.size(), compressedState.data(), compressedState.size());
+
+    if (ZSTD_isError(decompressedSize) || decompressedSize != stateSize)
+    {
+        return false;
+    }
+
+    bool isStarted = false;
+
+    Core::RunAsCPUThread([&]
+    {
+        if (targetFrame >= Movie::GetCurrentFrame())
+        {
+            return;
+        }
+
+        State::LoadFromBuffer(state);
+
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        // Checkpoints past the one being loaded belong to the timeline being abandoned
+        while (!_checkpoints.empty() && _checkpoints.back()._frameNumber > targetFrame)
+        {
+            _checkpoints.pop_back();
+        }
+
+        _pollIndex = _checkpoints.back()._pollIndex;
+        _replayTargetFrame = targetFrame;
+        _isReplaying = true;
+        isStarted = true;
+    });
+
+    return isStarted;
+}
+
+void RewindBuffer::Invalidate()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    // The loaded state shares no history with what was recorded, so checkpoints start over from it. With no inputs left, a
+    // rewind in progress finishes at the next poll.
+    _checkpoints.clear();
+    _inputs.clear();
+    _firstInputPollIndex = _pollIndex;
+    _timeline++;
+}
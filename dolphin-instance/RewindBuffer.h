@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Common/CommonTypes.h"
+#include "InputCommon/GCPadStatus.h"
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+// Ring of compressed save states taken every few frames, plus every input polled since the oldest one.
+// Rewinding loads the newest checkpoint at or before the target frame and replays the recorded inputs up to it, which is
+// deterministic and lands on the same state the original run had at the target frame's input poll.
+class RewindBuffer
+{
+public:
+	void Configure(int intervalFrames, int maxCheckpoints);
+	bool IsEnabled() const { return _isEnabled.load(std::memory_order_relaxed); }
+	bool IsReplaying() const { return _isReplaying.load(std::memory_order_relaxed); }
+
+	// CPU thread, once each controller's input is final. Returns true when a checkpoint should be captured.
+	bool RecordInput(int controllerId, const GCPadStatus& padStatus, u64 frameNumber);
+	// CPU thread, while replaying. Returns true once the target frame's poll has been replayed.
+	bool ReplayInput(int controllerId, GCPadStatus& outPadStatus);
+
+	// Host thread. The state is saved through runWithCpuPaused, which must run its job with the CPU paused.
+	void CaptureCheckpoint(const std::function<void(const std::function<void()>&)>& runWithCpuPaused);
+	bool BeginRewind(u64 targetFrame);
+	// Host thread, after loading a state from anywhere else. A rewind in progress ends at the next poll.
+	void Invalidate();
+
+private:
+	static constexpr int LAST_CONTROLLER = 3;
+
+	struct Checkpoint
+	{
+		std::vector<u8> _compressedState;
+		size_t _stateSize = 0;
+		u64 _frameNumber = 0;
+		u64 _pollIndex = 0;
+		u64 _timeline = 0;
+	};
+
+	struct PolledInput
+	{
+		u64 _frameNumber = 0;
+		GCPadStatus _padStatuses[4];
+	};
+
+	void FinishReplay(size_t replayedInputCount);
+
+	std::mutex _mutex;
+	std::atomic<bool> _isEnabled = false;
+	std::atomic<bool> _isReplaying = false;
+	bool _isCapturePending = false;
+	int _intervalFrames = 30;
+	size_t _maxCheckpoints = 60;
+
+	std::deque<Checkpoint> _checkpoints;
+	std::deque<PolledInput> _inputs;
+	GCPadStatus _currentPadStatuses[4];
+	u64 _firstInputPollIndex = 0;
+	u64 _pollIndex = 0;
+	u64 _replayTargetFrame = 0;
+	u64 _timeline = 0;					// Bumped whenever the recorded history is dropped, to reject captures already in flight
+};
@@ -0,0 +1,205 @@
+#include "SaveStateStore.h"
+
+#include "Common/FileUtil.h"
+
+#include <xxhash.h>
+#include <zstd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+    constexpr u32 MANIFEST_MAGIC = 0x4D535344;  // "DSSM"
+    constexpr u32 MANIFEST_VERSION = 1;
+    constexpr int COMPRESSION_LEVEL = 1;
+    constexpr u32 MIN_CHUNK_SIZE = 4 * 1024;
+    constexpr u64 MAX_STATE_SIZE = u64(1) << 30;    // Far beyond any real state, only bounds what a bad manifest can allocate
+
+    struct ManifestHeader
+    {
+        u32 magic;
+        u32 version;
+        u64 stateSize;
+        u32 chunkSize;
+        u32 chunkCount;
+    };
+}
+
+SaveStateStore::~SaveStateStore()
+{
+    ZSTD_freeCCtx(_compressContext);
+    ZSTD_freeDCtx(_decompressContext);
+}
+
+SaveStateStore::ChunkHash SaveStateStore::HashChunk(const u8* data, size_t size)
+{
+    // 128 bits makes accidental collisions a non-issue for emulator RAM, and XXH3 runs at memory bandwidth
+    const XXH128_hash_t hash = XXH3_128bits(data, size);
+
+    return { u64(hash.high64), u64(hash.low64) };
+}
+
+std::string SaveStateStore::GetChunkPath(const std::string& storeDirectory, const ChunkHash& hash)
+{
+    char name[33];
+    std::snprintf(name, sizeof(name), "%016llx%016llx", (unsigned long long)hash[0], (unsigned long long)hash[1]);
+
+    return storeDirectory + "/chunks/" + std::string(name, 2) + "/" + name + ".zst";
+}
+
+std::string SaveStateStore::GetManifestPath(const std::string& storeDirectory, const std::string& stateName)
+{
+    return storeDirectory + "/states/" + stateName + ".manifest";
+}
+
+bool SaveStateStore::WriteFileAtomic(const std::string& filePath, const void* data, size_t size)
+{
+    std::string tempPath = filePath + "." + _writerTag + "." + std::to_string(_tempFileCounter++) + ".tmp";
+
+    File::CreateFullPath(filePath);
+
+    {
+        File::IOFile file(tempPath, "wb");
+
+        if (!file || !file.WriteBytes(data, size))
+        {
+            file.Close();
+            File::Delete(tempPath);
+            return false;
+        }
+    }
+
+    if (!File::Rename(tempPath, filePath))
+    {
+        File::Delete(tempPath);
+
+        // Another writer may have published the same content addressed file first
+        return File::Exists(filePath);
+    }
+
+    return true;
+}
+
+SaveStateStoreResult SaveStateStore::Save(const std::string& storeDirectory, const std::string& stateName, const std::vector<u8>& state, u32 chunkSize)
+{
+    SaveStateStoreResult result;
+
+    if (storeDirectory.empty() || stateName.empty() || state.empty())
+    {
+        return result;
+    }
+
+    if (!_compressContext)
+    {
+        _compressContext = ZSTD_createCCtx();
+    }
+
+    chunkSize = std::max(chunkSize, MIN_CHUNK_SIZE);
+    _compressBuffer.resize(ZSTD_compressBound(chunkSize));
+
+    ManifestHeader header = { MANIFEST_MAGIC, MANIFEST_VERSION, state.size(), chunkSize, u32((state.size() + chunkSize - 1) / chunkSize) };
+    std::vector<ChunkHash> chunkHashes;
+    chunkHashes.reserve(header.chunkCount);
+
+    for (size_t offset = 0; offset < state.size(); offset += chunkSize)
+    {
+        const size_t thisChunkSize = std::min(size_t(chunkSize), state.size() - offset);
+        const ChunkHash hash = HashChunk(state.data() + offset, thisChunkSize);
+        chunkHashes.push_back(hash);
+
+        // Checked every time rather than remembered, since the store may be pruned by another process at any point
+        std::string chunkPath = GetChunkPath(storeDirectory, hash);
+
+        if (!File::Exists(chunkPath))
+        {
+            size_t compressedSize = ZSTD_compressCCtx(_compressContext, _compressBuffer.data(), _compressBuffer.size(), state.data() + offset, thisChunkSize, COMPRESSION_LEVEL);
+
+            if (ZSTD_isError(compressedSize) || !WriteFileAtomic(chunkPath, _compressBuffer.data(), compressedSize))
+            {
+                return result;
+            }
+
+            result.newChunks++;
+            result.bytesWritten += compressedSize;
+        }
+    }
+
+    std::vector<u8> manifest(sizeof(header) + chunkHashes.size() * sizeof(ChunkHash));
+    std::memcpy(manifest.data(), &header, sizeof(header));
+    std::memcpy(manifest.data() + sizeof(header), chunkHashes.data(), chunkHashes.size() * sizeof(ChunkHash));
+
+    result.success = WriteFileAtomic(GetManifestPath(storeDirectory, stateName), manifest.data(), manifest.size());
+    result.totalChunks = header.chunkCount;
+    result.bytesWritten += manifest.size();
+
+    return result;
+}
+
+bool SaveStateStore::Load(const std::string& storeDirectory, const std::string& stateName, std::vector<u8>& outState)
+{
+    File::IOFile manifestFile(GetManifestPath(storeDirectory, stateName), "rb");
+    ManifestHeader header;
+
+    if (!manifestFile || !manifestFile.ReadBytes(&header, sizeof(header)) || header.magic != MANIFEST_MAGIC || header.version != MANIFEST_VERSION)
+    {
+        return false;
+    }
+
+    // Any writer can put a manifest in a shared store, so its layout is checked before any of it sizes a buffer or a copy
+    if (header.chunkSize == 0 || header.stateSize == 0 || header.stateSize > MAX_STATE_SIZE
+        || u64(header.chunkCount) != header.stateSize / header.chunkSize + (header.stateSize % header.chunkSize != 0 ? 1 : 0)
+        || manifestFile.GetSize() != sizeof(header) + u64(header.chunkCount) * sizeof(ChunkHash))
+    {
+        return false;
+    }
+
+    std::vector<ChunkHash> chunkHashes(header.chunkCount);
+
+    if (!manifestFile.ReadBytes(chunkHashes.data(), chunkHashes.size() * sizeof(ChunkHash)))
+    {
+        return false;
+    }
+
+    if (!_decompressContext)
+    {
+        _decompressContext = ZSTD_createDCtx();
+    }
+
+    outState.resize(header.stateSize);
+    std::vector<u8> compressed;
+
+    for (u32 chunkIndex = 0; chunkIndex < header.chunkCount; chunkIndex++)
+    {
+        const size_t offset = size_t(chunkIndex) * header.chunkSize;
+        const size_t thisChunkSize = std::min(size_t(header.chunkSize), size_t(header.stateSize) - offset);
+        File::IOFile chunkFile(GetChunkPath(storeDirectory, chunkHashes[chunkIndex]), "rb");
+
+        if (!chunkFile)
+        {
+            return false;
+        }
+
+        compressed.resize(chunkFile.GetSize());
+
+        if (!chunkFile.ReadBytes(compressed.data(), compressed.size()))
+        {
+            return false;
+        }
+
+        size_t decompressedSize = ZSTD_decompressDCtx(_decompressContext, outState.data() + offset, thisChunkSize, compressed.data(), compressed.size());
+
+        if (ZSTD_isError(decompressedSize) || decompressedSize != thisChunkSize)
+        {
+            return false;
+        }
+
+        if (HashChunk(outState.data() + offset, thisChunkSize) != chunkHashes[chunkIndex])
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
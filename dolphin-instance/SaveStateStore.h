@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Common/CommonTypes.h"
+
+#include <array>
+#include <string>
+#include <vector>
+
+struct ZSTD_CCtx_s;
+struct ZSTD_DCtx_s;
+
+struct SaveStateStoreResult
+{
+	bool success = false;
+	u32 totalChunks = 0;
+	u32 newChunks = 0;
+	u64 bytesWritten = 0;
+};
+
+// Content addressed save state storage shared by every instance on a host.
+// States are split into fixed size chunks, and each unique chunk is stored once, zstd compressed, under its 128 bit hash:
+//   <store>/chunks/<2 hex>/<32 hex>.zst
+//   <store>/states/<name>.manifest
+// Every file is written to a unique temporary name and renamed into place, so concurrent writers never expose partial files,
+// and a manifest is only published after all of its chunks exist. Loads check every manifest and chunk, since any process
+// may have written them.
+class SaveStateStore
+{
+public:
+	~SaveStateStore();
+
+	void SetWriterTag(const std::string& writerTag) { _writerTag = writerTag; }
+
+	SaveStateStoreResult Save(const std::string& storeDirectory, const std::string& stateName, const std::vector<u8>& state, u32 chunkSize);
+	bool Load(const std::string& storeDirectory, const std::string& stateName, std::vector<u8>& outState);
+
+private:
+	using ChunkHash = std::array<u64, 2>;
+
+	static ChunkHash HashChunk(const u8* data, size_t size);
+	static std::string GetChunkPath(const std::string& storeDirectory, const ChunkHash& hash);
+	static std::string GetManifestPath(const std::string& storeDirectory, const std::string& stateName);
+
+	bool WriteFileAtomic(const std::string& filePath, const void* data, size_t size);
+
+	std::string _writerTag;
+	u64 _tempFileCounter = 0;
+
+	ZSTD_CCtx_s* _compressContext = nullptr;
+	ZSTD_DCtx_s* _decompressContext = nullptr;
+	std::vector<u8> _compressBuffer;
+};
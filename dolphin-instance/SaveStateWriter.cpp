@@ -0,0 +1,115 @@
+#include "SaveStateWriter.h"
+
+#include "InstanceUtils.h"
+
+#include "Common/FileUtil.h"
+#include "Core/HW/GCMemcard/GCMemcardUtils.h"
+#include "Core/State.h"
+
+#include <vector>
+
+SaveStateWriter::~SaveStateWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(_queueMutex);
+        _isStopping = true;
+    }
+
+    _queueCondition.notify_all();
+
+    if (_thread.joinable())
+    {
+        _thread.join();
+    }
+}
+
+void SaveStateWriter::Save(const std::string& filePathNoExtension, bool saveMemoryCards, std::function<void()> onDurable)
+{
+    std::string savFile = filePathNoExtension + ".sav";
+
+    {
+        // Dolphin silently skips a save if its state buffer is locked, which State::Flush on the worker would do
+        std::lock_guard<std::mutex> lock(_stateFileMutex);
+
+        if (File::Exists(savFile))
+        {
+            File::Delete(savFile);
+        }
+
+        // Without waiting, this returns once the state is captured on the CPU thread, and Dolphin compresses and writes it
+        // on its own save thread
+        State::SaveAs(savFile, false);
+    }
+
+    // Copied alongside the state, since emulation resumes before the worker gets to them and the game may save meanwhile
+    std::vector<Memcard::Savefile> savefilesA;
+    std::vector<Memcard::Savefile> savefilesB;
+
+    if (saveMemoryCards)
+    {
+        InstanceUtils::CaptureGci(DolphinSlot::SlotA, savefilesA);
+        InstanceUtils::CaptureGci(DolphinSlot::SlotB, savefilesB);
+    }
+
+    std::lock_guard<std::mutex> lock(_queueMutex);
+
+    _jobs.push([this, filePathNoExtension, saveMemoryCards, savefilesA = std::move(savefilesA), savefilesB = std::move(savefilesB),
+        onDurable = std::move(onDurable)]
+    {
+        {
+            std::lock_guard<std::mutex> lock(_stateFileMutex);
+            State::Flush();
+        }
+
+        if (saveMemoryCards)
+        {
+            InstanceUtils::WriteGci(savefilesA, filePathNoExtension + ".cardA.gci");
+            InstanceUtils::WriteGci(savefilesB, filePathNoExtension + ".cardB.gci");
+        }
+
+        if (onDurable)
+        {
+            onDurable();
+        }
+    });
+
+    if (!_thread.joinable())
+    {
+        _thread = std::thread(&SaveStateWriter::WorkerLoop, this);
+    }
+
+    _queueCondition.notify_one();
+}
+
+void SaveStateWriter::WaitForIdle()
+{
+    std::unique_lock<std::mutex> lock(_queueMutex);
+    _idleCondition.wait(lock, [this] { return _jobs.empty() && !_isBusy; });
+}
+
+void SaveStateWriter::WorkerLoop()
+{
+    std::unique_lock<std::mutex> lock(_queueMutex);
+
+    while (true)
+    {
+        _queueCondition.wait(lock, [this] { return _isStopping || !_jobs.empty(); });
+
+        // Drain queued saves before stopping, so nothing that was acknowledged as captured is lost
+        if (_jobs.empty())
+        {
+            return;
+        }
+
+        std::function<void()> job = std::move(_jobs.front());
+        _jobs.pop();
+        _isBusy = true;
+
+        lock.unlock();
+        job();
+        lock.lock();
+
+        _isBusy = false;
+        _idleCondition.notify_all();
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+
+// Splits save state creation into a fast capture of the state and memory card saves on the calling thread, and a background
+// phase that waits for the .sav to be compressed and written, then writes out the captured saves. Jobs complete in submission order.
+class SaveStateWriter
+{
+public:
+	~SaveStateWriter();
+
+	// Captures the emulator state before returning. onDurable is invoked from the worker thread once every file is on disk.
+	void Save(const std::string& filePathNoExtension, bool saveMemoryCards, std::function<void()> onDurable);
+
+	// Blocks until every queued save is durable. Call before anything else reads or writes state files.
+	void WaitForIdle();
+
+private:
+	void WorkerLoop();
+
+	std::mutex _stateFileMutex;
+	std::mutex _queueMutex;
+	std::condition_variable _queueCondition;
+	std::condition_variable _idleCondition;
+	std::queue<std::function<void()>> _jobs;
+	std::thread _thread;
+	bool _isBusy = false;
+	bool _isStopping = false;
+};
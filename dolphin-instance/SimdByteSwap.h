@@ -0,0 +1,25 @@
+#pragma once
+
+#include "Common/CommonTypes.h"
+#include "Common/Intrinsics.h"
+
+// SSE2 byte swaps for whole registers of big endian emulated values. SSSE3 would allow a single pshufb,
+// but shifts and shuffles keep this usable on any x86-64 host Dolphin supports.
+#ifdef _M_X86_64
+inline __m128i SimdSwap16(__m128i value)
+{
+    return _mm_or_si128(_mm_slli_epi16(value, 8), _mm_srli_epi16(value, 8));
+}
+
+inline __m128i SimdSwap32(__m128i value)
+{
+    value = SimdSwap16(value);
+    value = _mm_shufflelo_epi16(value, _MM_SHUFFLE(2, 3, 0, 1));
+    return _mm_shufflehi_epi16(value, _MM_SHUFFLE(2, 3, 0, 1));
+}
+
+inline __m128i SimdSwap64(__m128i value)
+{
+    return _mm_shuffle_epi32(SimdSwap32(value), _MM_SHUFFLE(2, 3, 0, 1));
+}
+#endif
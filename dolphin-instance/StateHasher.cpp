@@ -0,0 +1,185 @@
+#include "StateHasher.h"
+
+#include "InstanceUtils.h"
+
+#include "Core/HW/Memmap.h"
+
+#include <xxhash.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    constexpr u32 MEM1_BASE_ADDRESS = 0x80000000;
+    constexpr u32 MEM2_BASE_ADDRESS = 0x90000000;
+}
+
+void StateHasher::Configure(const std::vector<DolphinMemoryRegion>& memoryRegions, const std::vector<DolphinMemoryRegion>& excludedRegions, int blockSize)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    _memoryRegions = memoryRegions;
+    _excludedRegions = excludedRegions;
+    _blockSize = size_t(std::max(blockSize, 16));
+    _maskedBlock.resize(_blockSize);
+    _hashedRegions.clear();
+    _combinedHash = 0;
+    _isConfigured = true;
+}
+
+bool StateHasher::IsConfigured()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    return _isConfigured;
+}
+
+u64 StateHasher::Compute()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (!_isConfigured)
+    {
+        return 0;
+    }
+
+    std::vector<Span> spans;
+
+    if (_memoryRegions.empty())
+    {
+        spans.push_back({ MEM1_BASE_ADDRESS, Memory::GetRamSizeReal() });
+
+        if (Memory::m_pEXRAM)
+        {
+            spans.push_back({ MEM2_BASE_ADDRESS, Memory::GetExRamSizeReal() });
+        }
+    }
+    else
+    {
+        ResolveSpans(_memoryRegions, spans);
+    }
+
+    std::vector<Span> excludedSpans;
+    ResolveSpans(_excludedRegions, excludedSpans);
+
+    // Regions dropped since the last call take their blocks out of the combined hash
+    for (size_t index = spans.size(); index < _hashedRegions.size(); index++)
+    {
+        ResetRegion(_hashedRegions[index]);
+    }
+
+    _hashedRegions.resize(spans.size());
+
+    for (size_t index = 0; index < spans.size(); index++)
+    {
+        const Span& span = spans[index];
+        HashedRegion& region = _hashedRegions[index];
+        const u8* current = span._size > 0 ? InstanceUtils::GetPointerForRange(span._address, span._size) : nullptr;
+
+        if (!current)
+        {
+            ResetRegion(region);
+            continue;
+        }
+
+        std::vector<Span> excluded;
+
+        for (const Span& excludedSpan : excludedSpans)
+        {
+            const u64 start = std::max(u64(excludedSpan._address), u64(span._address));
+            const u64 end = std::min(u64(excludedSpan._address) + excludedSpan._size, u64(span._address) + span._size);
+
+            if (start < end)
+            {
+                excluded.push_back({ u32(start - span._address), u32(end - start) });
+            }
+        }
+
+        // A pointer chain that moved, or exclusions that moved, invalidate every block of the region
+        if (!(region._span == span) || region._excluded != excluded)
+        {
+            ResetRegion(region);
+            region._span = span;
+            region._excluded = std::move(excluded);
+            region._snapshot.resize(span._size);
+            region._blockHashes.assign((span._size + _blockSize - 1) / _blockSize, 0);
+        }
+
+        UpdateRegion(region, index, current);
+    }
+
+    return _combinedHash;
+}
+
+void StateHasher::ResolveSpans(const std::vector<DolphinMemoryRegion>& regions, std::vector<Span>& outSpans) const
+{
+    outSpans.clear();
+
+    for (const DolphinMemoryRegion& region : regions)
+    {
+        if (region.NumberOfBytes > 0)
+        {
+            outSpans.push_back({ InstanceUtils::ResolvePointer(region.Address, region.PointerOffsets), u32(region.NumberOfBytes) });
+        }
+    }
+}
+
+// Called with _mutex held
+void StateHasher::ResetRegion(HashedRegion& region)
+{
+    for (u64 blockHash : region._blockHashes)
+    {
+        _combinedHash ^= blockHash;
+    }
+
+    region = HashedRegion();
+}
+
+// Called with _mutex held
+void StateHasher::UpdateRegion(HashedRegion& region, size_t regionIndex, const u8* current)
+{
+    const size_t size = region._snapshot.size();
+
+    for (size_t offset = 0, block = 0; offset < size; offset += _blockSize, block++)
+    {
+        const size_t length = std::min(_blockSize, size - offset);
+        const u8* bytes = current + offset;
+
+        for (const Span& excluded : region._excluded)
+        {
+            const size_t start = std::max(size_t(excluded._address), offset);
+            const size_t end = std::min(size_t(excluded._address) + excluded._size, offset + length);
+
+            if (start >= end)
+            {
+                continue;
+            }
+
+            if (bytes != _maskedBlock.data())
+            {
+                std::memcpy(_maskedBlock.data(), bytes, length);
+                bytes = _maskedBlock.data();
+            }
+
+            std::memset(_maskedBlock.data() + (start - offset), 0, end - start);
+        }
+
+        if (region._isValid && std::memcmp(bytes, region._snapshot.data() + offset, length) == 0)
+        {
+            continue;
+        }
+
+        std::memcpy(region._snapshot.data() + offset, bytes, length);
+
+        // Seeding with the region and block position keeps identical blocks in different places from cancelling out in the xor.
+        // The position is relative to the region, so a pointer chain resolving elsewhere still hashes the same contents alike.
+        const u64 seed = (u64(regionIndex) << 32) | u64(offset);
+        const u64 blockHash = XXH3_64bits_withSeed(bytes, length, seed);
+
+        _combinedHash ^= region._blockHashes[block] ^ blockHash;
+        region._blockHashes[block] = blockHash;
+    }
+
+    region._isValid = true;
+}
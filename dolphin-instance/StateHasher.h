@@ -0,0 +1,53 @@
+#pragma once
+
+#include "dolphin-ipc/IpcStructs.h"
+
+#include "Common/CommonTypes.h"
+
+#include <mutex>
+#include <vector>
+
+// Computes a canonical hash of the configured RAM, so different input sequences reaching the same game state hash the same.
+// Regions are split into blocks hashed independently and combined with xor. Each call compares the blocks against a snapshot
+// and only rehashes the ones that changed, so the cost is mostly a memcmp of the hashed RAM.
+class StateHasher
+{
+public:
+	// Empty regions hash all of MEM1 and MEM2. Excluded regions are hashed as zeroes wherever they overlap.
+	void Configure(const std::vector<DolphinMemoryRegion>& memoryRegions, const std::vector<DolphinMemoryRegion>& excludedRegions, int blockSize);
+	bool IsConfigured();
+
+	// Returns zero until configured. Pointer chains are re-resolved every call.
+	u64 Compute();
+
+private:
+	struct Span
+	{
+		u32 _address = 0;
+		u32 _size = 0;
+
+		bool operator==(const Span& other) const { return _address == other._address && _size == other._size; }
+	};
+
+	struct HashedRegion
+	{
+		Span _span;
+		std::vector<Span> _excluded;	// Offsets into the region
+		std::vector<u8> _snapshot;		// Masked contents as of the last call
+		std::vector<u64> _blockHashes;
+		bool _isValid = false;
+	};
+
+	void ResolveSpans(const std::vector<DolphinMemoryRegion>& regions, std::vector<Span>& outSpans) const;
+	void ResetRegion(HashedRegion& region);
+	void UpdateRegion(HashedRegion& region, size_t regionIndex, const u8* current);
+
+	std::mutex _mutex;
+	bool _isConfigured = false;
+	std::vector<DolphinMemoryRegion> _memoryRegions;
+	std::vector<DolphinMemoryRegion> _excludedRegions;
+	std::vector<HashedRegion> _hashedRegions;
+	std::vector<u8> _maskedBlock;
+	size_t _blockSize = 256;
+	u64 _combinedHash = 0;
+};
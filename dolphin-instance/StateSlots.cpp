@@ -0,0 +1,256 @@
+#include "StateSlots.h"
+
+#include "Common/FileUtil.h"
+#include "Core/Movie.h"
+#include "Core/State.h"
+
+#include <algorithm>
+#include <cstring>
+
+bool StateSlots::Save(int slot, int baseSlot, int maxChainDepth)
+{
+    State::SaveToBuffer(_captureBuffer);
+
+    if (_captureBuffer.empty())
+    {
+        return false;
+    }
+
+    // Anything that depends on the old contents of this slot must stop doing so before it is overwritten
+    DetachDependents(slot);
+
+    if (baseSlot == slot || !_slots.count(baseSlot))
+    {
+        baseSlot = -1;
+    }
+    else if (GetChainDepth(baseSlot) + 1 > maxChainDepth)
+    {
+        // Rebase onto the root of the chain. The delta grows by whatever changed along the chain, but loads stay one hop
+        baseSlot = GetChainRoot(baseSlot);
+    }
+
+    if (baseSlot >= 0 && baseSlot != slot && Reconstruct(baseSlot, _baseBuffer))
+    {
+        Encode(_slots[slot], _captureBuffer, baseSlot, &_baseBuffer);
+    }
+    else
+    {
+        Encode(_slots[slot], _captureBuffer, -1, nullptr);
+    }
+
+    _slots[slot]._frameNumber = Movie::GetCurrentFrame();
+
+    return true;
+}
+
+bool StateSlots::Load(int slot)
+{
+    if (!Reconstruct(slot, _captureBuffer))
+    {
+        return false;
+    }
+
+    State::LoadFromBuffer(_captureBuffer);
+
+    return true;
+}
+
+void StateSlots::Free(const std::vector<int>& slots)
+{
+    if (slots.empty())
+    {
+        _slots.clear();
+        return;
+    }
+
+    for (int slot : slots)
+    {
+        if (_slots.count(slot))
+        {
+            DetachDependents(slot);
+            _slots.erase(slot);
+        }
+    }
+}
+
+bool StateSlots::Persist(int slot, const std::string& savFile)
+{
+    std::vector<u8> slotState;
+
+    if (!Reconstruct(slot, slotState))
+    {
+        return false;
+    }
+
+    // Dolphin can only write the compressed .sav format from the live emulator state, so swap the slot in, write it, and
+    // restore whatever was running before
+    std::vector<u8> currentState;
+    State::SaveToBuffer(currentState);
+    State::LoadFromBuffer(slotState);
+
+    if (File::Exists(savFile))
+    {
+        File::Delete(savFile);
+    }
+    State::SaveAs(savFile, true);
+
+    State::LoadFromBuffer(currentState);
+
+    return true;
+}
+
+std::vector<DolphinStateSlotInfo> StateSlots::List() const
+{
+    std::vector<DolphinStateSlotInfo> slotInfos;
+    slotInfos.reserve(_slots.size());
+
+    for (const auto& [slot, stateSlot] : _slots)
+    {
+        DolphinStateSlotInfo info;
+        info.Slot = slot;
+        info.SizeBytes = stateSlot._buffer.size() + stateSlot._changedBlocks.size() * sizeof(u32);
+        info.FrameNumber = stateSlot._frameNumber;
+        info.BaseSlot = stateSlot._baseSlot;
+        slotInfos.push_back(info);
+    }
+
+    return slotInfos;
+}
+
+u64 StateSlots::GetTotalSize() const
+{
+    u64 totalSize = 0;
+
+    for (const auto& [slot, stateSlot] : _slots)
+    {
+        totalSize += stateSlot._buffer.size() + stateSlot._changedBlocks.size() * sizeof(u32);
+    }
+
+    return totalSize;
+}
+
+bool StateSlots::Reconstruct(int slot, std::vector<u8>& outState) const
+{
+    std::vector<const Slot*> chain;
+
+    for (auto it = _slots.find(slot); it != _slots.end(); it = _slots.find(it->second._baseSlot))
+    {
+        chain.push_back(&it->second);
+
+        if (it->second._baseSlot < 0)
+        {
+            break;
+        }
+    }
+
+    if (chain.empty() || chain.back()->_baseSlot >= 0 || chain.back()->_buffer.empty())
+    {
+        return false;
+    }
+
+    // Start from the full root state, then apply each delta from oldest to newest in a single pass
+    outState.assign(chain.back()->_buffer.begin(), chain.back()->_buffer.end());
+
+    for (auto it = chain.rbegin() + 1; it != chain.rend(); ++it)
+    {
+        const Slot& delta = **it;
+        const u8* blockData = delta._buffer.data();
+        outState.resize(delta._stateSize);
+
+        for (u32 block : delta._changedBlocks)
+        {
+            const size_t offset = size_t(block) * DELTA_BLOCK_SIZE;
+            const size_t blockSize = std::min(DELTA_BLOCK_SIZE, delta._stateSize - offset);
+            std::memcpy(outState.data() + offset, blockData, blockSize);
+            blockData += blockSize;
+        }
+    }
+
+    return true;
+}
+
+int StateSlots::GetChainDepth(int slot) const
+{
+    int depth = 0;
+
+    for (auto it = _slots.find(slot); it != _slots.end() && it->second._baseSlot >= 0; it = _slots.find(it->second._baseSlot))
+    {
+        depth++;
+    }
+
+    return depth;
+}
+
+int StateSlots::GetChainRoot(int slot) const
+{
+    for (auto it = _slots.find(slot); it != _slots.end(); it = _slots.find(it->second._baseSlot))
+    {
+        if (it->second._baseSlot < 0)
+        {
+            return it->first;
+        }
+    }
+
+    return -1;
+}
+
+void StateSlots::Encode(Slot& stateSlot, std::vector<u8>& state, int baseSlot, const std::vector<u8>* baseState)
+{
+    stateSlot._baseSlot = baseSlot;
+    stateSlot._stateSize = state.size();
+    stateSlot._changedBlocks.clear();
+
+    if (!baseState)
+    {
+        // Swap rather than copy, the capture buffer is refilled on the next save anyway
+        stateSlot._buffer.swap(state);
+        return;
+    }
+
+    stateSlot._buffer.clear();
+
+    for (size_t offset = 0; offset < state.size(); offset += DELTA_BLOCK_SIZE)
+    {
+        const size_t blockSize = std::min(DELTA_BLOCK_SIZE, state.size() - offset);
+        const bool isChanged = offset + blockSize > baseState->size() || std::memcmp(state.data() + offset, baseState->data() + offset, blockSize) != 0;
+
+        if (isChanged)
+        {
+            stateSlot._changedBlocks.push_back(u32(offset / DELTA_BLOCK_SIZE));
+            stateSlot._buffer.insert(stateSlot._buffer.end(), state.begin() + offset, state.begin() + offset + blockSize);
+        }
+    }
+
+    stateSlot._buffer.shrink_to_fit();
+}
+
+void StateSlots::DetachDependents(int slot)
+{
+    auto it = _slots.find(slot);
+
+    if (it == _slots.end())
+    {
+        return;
+    }
+
+    const int newBaseSlot = it->second._baseSlot;
+    std::vector<u8> newBaseState;
+
+    if (newBaseSlot >= 0)
+    {
+        Reconstruct(newBaseSlot, newBaseState);
+    }
+
+    // Rebase direct dependents onto this slot's own base, which keeps their chains valid and no deeper than before
+    for (auto& [dependentSlot, dependent] : _slots)
+    {
+        if (dependent._baseSlot != slot)
+        {
+            continue;
+        }
+
+        std::vector<u8> dependentState;
+        Reconstruct(dependentSlot, dependentState);
+        Encode(dependent, dependentState, newBaseSlot, newBaseSlot >= 0 ? &newBaseState : nullptr);
+    }
+}
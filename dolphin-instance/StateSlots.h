@@ -0,0 +1,47 @@
+#pragma once
+
+#include "dolphin-ipc/IpcStructs.h"
+
+#include "Common/CommonTypes.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+// Numbered save states held in memory, so that searches that save and load constantly never touch the disk.
+// A slot can be stored as a delta against another slot, keeping only the blocks that differ. Delta chains are bounded, and
+// slots that depend on a slot being overwritten or freed are rebased first, so every slot stays loadable.
+// Only accessed from the IPC handler thread; Dolphin's buffer save/load hop to the CPU thread themselves.
+class StateSlots
+{
+public:
+	bool Save(int slot, int baseSlot = -1, int maxChainDepth = 8);
+	bool Load(int slot);
+	void Free(const std::vector<int>& slots);
+	bool Persist(int slot, const std::string& savFile);
+	std::vector<DolphinStateSlotInfo> List() const;
+	u64 GetTotalSize() const;
+
+private:
+	static constexpr size_t DELTA_BLOCK_SIZE = 128;
+
+	struct Slot
+	{
+		// Full state bytes, or the packed contents of _changedBlocks for a delta slot
+		std::vector<u8> _buffer;
+		std::vector<u32> _changedBlocks;
+		int _baseSlot = -1;
+		size_t _stateSize = 0;
+		u64 _frameNumber = 0;
+	};
+
+	bool Reconstruct(int slot, std::vector<u8>& outState) const;
+	int GetChainDepth(int slot) const;
+	int GetChainRoot(int slot) const;
+	void Encode(Slot& stateSlot, std::vector<u8>& state, int baseSlot, const std::vector<u8>* baseState);
+	void DetachDependents(int slot);
+
+	std::map<int, Slot> _slots;
+	std::vector<u8> _captureBuffer;
+	std::vector<u8> _baseBuffer;
+};
@@ -0,0 +1,157 @@
+#include "StepObserver.h"
+
+#include "InstanceUtils.h"
+
+#include "Core/HW/Memmap.h"
+#include "Core/HW/MMIO.h"
+#include "Core/Movie.h"
+
+#include <algorithm>
+
+namespace
+{
+    // VideoInterface registers, see VideoInterface.h for the field layouts
+    constexpr u32 VI_VERTICAL_TIMING = 0x0C002000;
+    constexpr u32 VI_FB_LEFT_TOP_HI = 0x0C00201C;
+    constexpr u32 VI_FB_LEFT_TOP_LO = 0x0C00201E;
+    constexpr u32 VI_FB_WIDTH = 0x0C002048;
+
+    u8 ClampToByte(int value)
+    {
+        return u8(std::clamp(value, 0, 255));
+    }
+}
+
+void StepObserver::Configure(const std::vector<DolphinMemoryRegion>& memoryRegions, int framebufferWidth, int framebufferHeight, bool grayscale)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    _memoryRegions = memoryRegions;
+    _framebufferWidth = std::max(framebufferWidth, 0);
+    _framebufferHeight = std::max(framebufferHeight, 0);
+    _grayscale = grayscale;
+}
+
+bool StepObserver::WantsFramebuffer()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    return _framebufferWidth > 0 && _framebufferHeight > 0;
+}
+
+void StepObserver::Capture(ToServerParams_OnInstanceStepCompleted& outObservation)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    outObservation._frameNumber = Movie::GetCurrentFrame();
+    outObservation._memoryRegions.resize(_memoryRegions.size());
+
+    for (size_t index = 0; index < _memoryRegions.size(); index++)
+    {
+        const DolphinMemoryRegion& region = _memoryRegions[index];
+        u32 address = InstanceUtils::ResolvePointer(region.Address, region.PointerOffsets);
+
+        outObservation._memoryRegions[index] = InstanceUtils::ReadBytes(address, region.NumberOfBytes);
+    }
+
+    if (_framebufferWidth > 0 && _framebufferHeight > 0 && CaptureFramebuffer(outObservation._framebuffer))
+    {
+        outObservation._framebufferWidth = _framebufferWidth;
+        outObservation._framebufferHeight = _framebufferHeight;
+        outObservation._framebufferGrayscale = _grayscale;
+    }
+}
+
+bool StepObserver::CaptureFramebuffer(std::vector<u8>& outPixels)
+{
+    // Sample the top field only, which is a full frame in progressive modes and plenty for a downscaled observation otherwise
+    u16 verticalTiming = Memory::mmio_mapping->Read<u16>(VI_VERTICAL_TIMING);
+    u32 topField = (u32(Memory::mmio_mapping->Read<u16>(VI_FB_LEFT_TOP_HI)) << 16) | Memory::mmio_mapping->Read<u16>(VI_FB_LEFT_TOP_LO);
+    u16 pictureConfiguration = Memory::mmio_mapping->Read<u16>(VI_FB_WIDTH);
+
+    u32 height = (verticalTiming >> 4) & 0x3FF;
+    u32 width = ((pictureConfiguration >> 8) & 0x7F) * 16;
+    u32 strideBytes = (pictureConfiguration & 0xFF) * 32;
+    u32 address = (topField & 0x10000000) != 0 ? (topField & 0xFFFFFF) << 5 : (topField & 0xFFFFFF);
+
+    if (width == 0 || height == 0 || strideBytes < width * 2)
+    {
+        return false;
+    }
+
+    const u8* xfb = InstanceUtils::GetPointerForRange(address, size_t(strideBytes) * (height - 1) + width * 2);
+
+    if (!xfb)
+    {
+        return false;
+    }
+
+    DownscaleXfb(xfb, width, height, strideBytes, _framebufferWidth, _framebufferHeight, _grayscale, outPixels);
+
+    return true;
+}
+
+void StepObserver::DownscaleXfb(const u8* xfb, u32 width, u32 height, u32 strideBytes, int outWidth, int outHeight, bool grayscale, std::vector<u8>& outPixels)
+{
+    const int channels = grayscale ? 1 : 3;
+    outPixels.resize(size_t(outWidth) * outHeight * channels);
+
+    // Source column range for each output column, shared by every row
+    std::vector<u32> columnStarts(outWidth + 1);
+
+    for (int column = 0; column <= outWidth; column++)
+    {
+        columnStarts[column] = u32(u64(column) * width / outWidth);
+    }
+
+    u8* out = outPixels.data();
+
+    for (int row = 0; row < outHeight; row++)
+    {
+        u32 rowStart = u32(u64(row) * height / outHeight);
+        u32 rowEnd = std::max(rowStart + 1, u32(u64(row + 1) * height / outHeight));
+
+        for (int column = 0; column < outWidth; column++)
+        {
+            u32 columnStart = columnStarts[column];
+            u32 columnEnd = std::max(columnStart + 1, columnStarts[column + 1]);
+
+            // YUYV stores two pixels in four bytes, Y0 U Y1 V, with the chroma shared by the pair
+            int sumY = 0;
+            int sumU = 0;
+            int sumV = 0;
+
+            for (u32 y = rowStart; y < rowEnd; y++)
+            {
+                const u8* line = xfb + size_t(y) * strideBytes;
+
+                for (u32 x = columnStart; x < columnEnd; x++)
+                {
+                    const u8* pair = line + (x & ~1u) * 2;
+
+                    sumY += line[x * 2];
+                    sumU += pair[1];
+                    sumV += pair[3];
+                }
+            }
+
+            int count = int((rowEnd - rowStart) * (columnEnd - columnStart));
+            int luma = sumY / count;
+
+            if (grayscale)
+            {
+                *out++ = u8(luma);
+                continue;
+            }
+
+            // BT.601 studio range to full range RGB
+            int c = luma - 16;
+            int d = sumU / count - 128;
+            int e = sumV / count - 128;
+
+            *out++ = ClampToByte((298 * c + 409 * e + 128) >> 8);
+            *out++ = ClampToByte((298 * c - 100 * d - 208 * e + 128) >> 8);
+            *out++ = ClampToByte((298 * c + 516 * d + 128) >> 8);
+        }
+    }
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "dolphin-ipc/DolphinIpcHandlerBase.h"
+#include "dolphin-ipc/IpcStructs.h"
+
+#include "Common/CommonTypes.h"
+
+#include <mutex>
+#include <vector>
+
+// Builds the observation returned by a Step call, on the CPU thread at the frame boundary the step ended on.
+// The framebuffer is sampled from the external framebuffer in RAM, which requires XFB copies to RAM to be enabled.
+class StepObserver
+{
+public:
+	void Configure(const std::vector<DolphinMemoryRegion>& memoryRegions, int framebufferWidth, int framebufferHeight, bool grayscale);
+	bool WantsFramebuffer();
+	void Capture(ToServerParams_OnInstanceStepCompleted& outObservation);
+
+	// Box filters a YUYV framebuffer down to outWidth x outHeight, as one luma byte or three RGB bytes per pixel
+	static void DownscaleXfb(const u8* xfb, u32 width, u32 height, u32 strideBytes, int outWidth, int outHeight, bool grayscale, std::vector<u8>& outPixels);
+
+private:
+	bool CaptureFramebuffer(std::vector<u8>& outPixels);
+
+	std::mutex _mutex;
+	std::vector<DolphinMemoryRegion> _memoryRegions;
+	int _framebufferWidth = 0;
+	int _framebufferHeight = 0;
+	bool _grayscale = true;
+};
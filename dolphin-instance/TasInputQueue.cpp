@@ -0,0 +1,116 @@
+#include "TasInputQueue.h"
+
+#include <algorithm>
+
+void TasInputQueue::Configure(int capacityFrames, int lowWaterFrames)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    _capacity = size_t(std::max(capacityFrames, 1));
+    _lowWaterFrames = size_t(std::clamp(lowWaterFrames, 0, int(_capacity) - 1));
+
+    for (int controllerId = 0; controllerId < NUM_CONTROLLERS; controllerId++)
+    {
+        _rings[controllerId] = Ring();
+        _isActive[controllerId] = false;
+    }
+
+    _hasReachedLowWater = false;
+}
+
+void TasInputQueue::Clear()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    for (int controllerId = 0; controllerId < NUM_CONTROLLERS; controllerId++)
+    {
+        _rings[controllerId]._head = 0;
+        _rings[controllerId]._count = 0;
+        _rings[controllerId]._isLowWaterArmed = false;
+        _isActive[controllerId] = false;
+    }
+
+    _hasReachedLowWater = false;
+}
+
+int TasInputQueue::Push(int controllerId, DolphinInputRecording inputs)
+{
+    if (controllerId < 0 || controllerId >= NUM_CONTROLLERS || !inputs.HasNext())
+    {
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    Ring& ring = _rings[controllerId];
+    ring._states.resize(_capacity);
+
+    int droppedInputs = 0;
+
+    while (inputs.HasNext())
+    {
+        DolphinControllerState state = inputs.PopNext();
+
+        if (ring._count == _capacity)
+        {
+            droppedInputs++;
+            continue;
+        }
+
+        ring._states[(ring._head + ring._count) % _capacity] = state;
+        ring._count++;
+    }
+
+    if (ring._count > _lowWaterFrames)
+    {
+        ring._isLowWaterArmed = true;
+    }
+
+    _isActive[controllerId].store(true, std::memory_order_release);
+
+    return droppedInputs;
+}
+
+bool TasInputQueue::Pop(int controllerId, DolphinControllerState& outState)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    Ring& ring = _rings[controllerId];
+
+    if (ring._count == 0)
+    {
+        return false;
+    }
+
+    outState = ring._states[ring._head];
+    ring._head = (ring._head + 1) % _capacity;
+    ring._count--;
+
+    if (ring._isLowWaterArmed && ring._count <= _lowWaterFrames)
+    {
+        ring._isLowWaterArmed = false;
+        _hasReachedLowWater = true;
+    }
+
+    return true;
+}
+
+bool TasInputQueue::TakeLowWater()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    bool hasReachedLowWater = _hasReachedLowWater;
+    _hasReachedLowWater = false;
+
+    return hasReachedLowWater;
+}
+
+void TasInputQueue::GetQueuedFrames(int outQueuedFrames[NUM_CONTROLLERS])
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    for (int controllerId = 0; controllerId < NUM_CONTROLLERS; controllerId++)
+    {
+        outQueuedFrames[controllerId] = int(_rings[controllerId]._count);
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "dolphin-ipc/IpcStructs.h"
+
+#include "Common/CommonTypes.h"
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+// Per controller ring buffers of TAS inputs queued ahead by the server, one entry per frame. The CPU thread takes one entry
+// per poll. A controller that runs dry keeps its last input, the way a real controller holds its state between polls.
+// The low water mark is edge sensitive: it fires once when a queue drains down to it, and is re-armed by refilling past it.
+class TasInputQueue
+{
+public:
+	static constexpr int NUM_CONTROLLERS = 4;
+
+	// Host thread. Both clear every queue.
+	void Configure(int capacityFrames, int lowWaterFrames);
+	void Clear();
+
+	// Host thread. Returns how many inputs did not fit and were dropped.
+	int Push(int controllerId, DolphinInputRecording inputs);
+
+	// A controller fed since the last clear replaces its hardware input
+	bool IsActive(int controllerId) const { return _isActive[controllerId].load(std::memory_order_acquire); }
+
+	// CPU thread. Returns false when the queue is empty, leaving outState as it was.
+	bool Pop(int controllerId, DolphinControllerState& outState);
+	// CPU thread, once per frame. Returns true once for every time a fed queue drained down to the low water mark.
+	bool TakeLowWater();
+
+	void GetQueuedFrames(int outQueuedFrames[NUM_CONTROLLERS]);
+
+private:
+	struct Ring
+	{
+		std::vector<DolphinControllerState> _states;
+		size_t _head = 0;
+		size_t _count = 0;
+		bool _isLowWaterArmed = false;
+	};
+
+	std::mutex _mutex;
+	std::array<Ring, NUM_CONTROLLERS> _rings;
+	std::atomic<bool> _isActive[NUM_CONTROLLERS] = {};
+	size_t _capacity = 600;
+	size_t _lowWaterFrames = 30;
+	bool _hasReachedLowWater = false;
+};
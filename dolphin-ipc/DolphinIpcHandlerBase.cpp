@@ -113,6 +113,27 @@ void DolphinIpcHandlerBase::updateIpcListen()
     }
 }
 
+bool DolphinIpcHandlerBase::ipcReceiveFromServer(DolphinIpcToInstanceData& outData)
+{
+    if (_serverToInstance == nullptr)
+    {
+        return false;
+    }
+
+    std::string rawData;
+
+    if (!_serverToInstance->recv(rawData))
+    {
+        return false;
+    }
+
+    std::stringstream memoryStream(rawData, std::ios::binary | std::ios::out | std::ios::in);
+    cereal::BinaryInputArchive deserializer(memoryStream);
+    deserializer(outData);
+
+    return true;
+}
+
 #define SERVER_DISPATCH(Name) case DolphinServerIpcCall::DolphinServer_ ## Name: DolphinServer_ ## Name(*data._params._params ## Name); break;
 void DolphinIpcHandlerBase::onInstanceToServerDataReceived(const DolphinIpcToServerData& data)
 {
@@ -128,6 +149,22 @@ void DolphinIpcHandlerBase::onInstanceToServerDataReceived(const DolphinIpcToSer
         SERVER_DISPATCH(OnInstanceMemoryRead)
         SERVER_DISPATCH(OnInstanceMemoryWrite)
         SERVER_DISPATCH(OnInstanceRenderGba)
+        SERVER_DISPATCH(OnInstanceMemoryWatchChanged)
+        SERVER_DISPATCH(OnInstanceMemoryScanned)
+        SERVER_DISPATCH(OnInstancePointerPathsScanned)
+        SERVER_DISPATCH(OnInstanceSharedRamMapped)
+        SERVER_DISPATCH(OnInstanceMemoryTriggerFired)
+        SERVER_DISPATCH(OnInstanceRamDiff)
+        SERVER_DISPATCH(OnInstanceStateSlotsListed)
+        SERVER_DISPATCH(OnInstanceStateStored)
+        SERVER_DISPATCH(OnInstanceSaveStateData)
+        SERVER_DISPATCH(OnInstanceMemoryCardImage)
+        SERVER_DISPATCH(OnInstanceStepCompleted)
+        SERVER_DISPATCH(OnInstanceInputSearchCompleted)
+        SERVER_DISPATCH(OnInstanceDesyncDetected)
+        SERVER_DISPATCH(OnInstanceStateHash)
+        SERVER_DISPATCH(OnInstanceScheduledCommandExecuted)
+        SERVER_DISPATCH(OnInstanceTasInputQueueStatus)
         case DolphinServerIpcCall::Null: default: std::cout << "NULL instance => server call!" << std::endl; break;
     }
 }
@@ -149,9 +186,48 @@ void DolphinIpcHandlerBase::onServerToInstanceDataReceived(const DolphinIpcToIns
         INSTANCE_DISPATCH(SetTasInput)
         INSTANCE_DISPATCH(CreateSaveState)
         INSTANCE_DISPATCH(LoadSaveState)
+        INSTANCE_DISPATCH(LoadMemoryCardData)
         INSTANCE_DISPATCH(FormatMemoryCard)
         INSTANCE_DISPATCH(ReadMemory)
         INSTANCE_DISPATCH(WriteMemory)
+        INSTANCE_DISPATCH(SubscribeMemoryWatches)
+        INSTANCE_DISPATCH(UnsubscribeMemoryWatches)
+        INSTANCE_DISPATCH(ScanMemory)
+        INSTANCE_DISPATCH(ClearMemoryScan)
+        INSTANCE_DISPATCH(ScanPointerPaths)
+        INSTANCE_DISPATCH(SetSharedRamMapping)
+        INSTANCE_DISPATCH(ReadMemoryTyped)
+        INSTANCE_DISPATCH(WriteMemoryTyped)
+        INSTANCE_DISPATCH(RegisterMemoryTriggers)
+        INSTANCE_DISPATCH(UnregisterMemoryTriggers)
+        INSTANCE_DISPATCH(StartRamDiff)
+        INSTANCE_DISPATCH(StopRamDiff)
+        INSTANCE_DISPATCH(SaveStateToSlot)
+        INSTANCE_DISPATCH(LoadStateFromSlot)
+        INSTANCE_DISPATCH(FreeStateSlots)
+        INSTANCE_DISPATCH(ListStateSlots)
+        INSTANCE_DISPATCH(PersistStateSlot)
+        INSTANCE_DISPATCH(SaveStateToStore)
+        INSTANCE_DISPATCH(LoadStateFromStore)
+        INSTANCE_DISPATCH(CreateSaveStateData)
+        INSTANCE_DISPATCH(LoadSaveStateData)
+        INSTANCE_DISPATCH(ConfigureRewind)
+        INSTANCE_DISPATCH(RewindToFrame)
+        INSTANCE_DISPATCH(FlushMemoryCards)
+        INSTANCE_DISPATCH(ReadMemoryCardImage)
+        INSTANCE_DISPATCH(WriteMemoryCardImage)
+        INSTANCE_DISPATCH(PersistMemoryCard)
+        INSTANCE_DISPATCH(SetStepMode)
+        INSTANCE_DISPATCH(StepFrames)
+        INSTANCE_DISPATCH(ConfigureObservation)
+        INSTANCE_DISPATCH(Step)
+        INSTANCE_DISPATCH(SearchInputs)
+        INSTANCE_DISPATCH(ConfigureStateHash)
+        INSTANCE_DISPATCH(GetStateHash)
+        INSTANCE_DISPATCH(ScheduleCommand)
+        INSTANCE_DISPATCH(ConfigureTasInputQueue)
+        INSTANCE_DISPATCH(QueueTasInputs)
+        INSTANCE_DISPATCH(ClearTasInputQueue)
         case DolphinInstanceIpcCall::Null: default: std::cout << "NULL server => instance call!" << std::endl; break;
     }
 }
@@ -39,6 +39,7 @@ public:
 	void initializeChannels(const std::string& uniqueChannelId, bool isInstance);
 
 	void updateIpcListen();
+	bool ipcReceiveFromServer(DolphinIpcToInstanceData& outData);	// Receives one pending call without dispatching it
 	void ipcSendToServer(const DolphinIpcToServerData& data);
 	void ipcSendToInstance(const DolphinIpcToInstanceData& data);
 
@@ -63,6 +64,46 @@ protected:
 	INSTANCE_FUNC(FormatMemoryCard)
 	INSTANCE_FUNC(ReadMemory)
 	INSTANCE_FUNC(WriteMemory)
+	INSTANCE_FUNC(SubscribeMemoryWatches)
+	INSTANCE_FUNC(UnsubscribeMemoryWatches)
+	INSTANCE_FUNC(ScanMemory)
+	INSTANCE_FUNC(ClearMemoryScan)
+	INSTANCE_FUNC(ScanPointerPaths)
+	INSTANCE_FUNC(SetSharedRamMapping)
+	INSTANCE_FUNC(ReadMemoryTyped)
+	INSTANCE_FUNC(WriteMemoryTyped)
+	INSTANCE_FUNC(RegisterMemoryTriggers)
+	INSTANCE_FUNC(UnregisterMemoryTriggers)
+	INSTANCE_FUNC(StartRamDiff)
+	INSTANCE_FUNC(StopRamDiff)
+	INSTANCE_FUNC(SaveStateToSlot)
+	INSTANCE_FUNC(LoadStateFromSlot)
+	INSTANCE_FUNC(FreeStateSlots)
+	INSTANCE_FUNC(ListStateSlots)
+	INSTANCE_FUNC(PersistStateSlot)
+	INSTANCE_FUNC(SaveStateToStore)
+	INSTANCE_FUNC(LoadStateFromStore)
+	INSTANCE_FUNC(CreateSaveStateData)
+	INSTANCE_FUNC(LoadSaveStateData)
+	INSTANCE_FUNC(ConfigureRewind)
+	INSTANCE_FUNC(RewindToFrame)
+	INSTANCE_FUNC(FlushMemoryCards)
+	INSTANCE_FUNC(ReadMemoryCardImage)
+	INSTANCE_FUNC(WriteMemoryCardImage)
+	INSTANCE_FUNC(PersistMemoryCard)
+	INSTANCE_FUNC(SetStepMode)
+	INSTANCE_FUNC(StepFrames)
+	INSTANCE_FUNC(ConfigureObservation)
+	INSTANCE_FUNC(Step)
+	INSTANCE_FUNC(SearchInputs)
+	INSTANCE_FUNC(ConfigureStateHash)
+	INSTANCE_FUNC(GetStateHash)
+	INSTANCE_FUNC(ScheduleCommand)
+	INSTANCE_FUNC(ConfigureTasInputQueue)
+	INSTANCE_FUNC(QueueTasInputs)
+	INSTANCE_FUNC(ClearTasInputQueue)
+
+	void onServerToInstanceDataReceived(const DolphinIpcToInstanceData& data);
 
 	// Server implemented functions
 protected:
@@ -79,6 +120,22 @@ protected:
 	SERVER_FUNC(OnInstanceMemoryRead)
 	SERVER_FUNC(OnInstanceMemoryWrite)
 	SERVER_FUNC(OnInstanceRenderGba)
+	SERVER_FUNC(OnInstanceMemoryWatchChanged)
+	SERVER_FUNC(OnInstanceMemoryScanned)
+	SERVER_FUNC(OnInstancePointerPathsScanned)
+	SERVER_FUNC(OnInstanceSharedRamMapped)
+	SERVER_FUNC(OnInstanceMemoryTriggerFired)
+	SERVER_FUNC(OnInstanceRamDiff)
+	SERVER_FUNC(OnInstanceStateSlotsListed)
+	SERVER_FUNC(OnInstanceStateStored)
+	SERVER_FUNC(OnInstanceSaveStateData)
+	SERVER_FUNC(OnInstanceMemoryCardImage)
+	SERVER_FUNC(OnInstanceStepCompleted)
+	SERVER_FUNC(OnInstanceInputSearchCompleted)
+	SERVER_FUNC(OnInstanceDesyncDetected)
+	SERVER_FUNC(OnInstanceStateHash)
+	SERVER_FUNC(OnInstanceScheduledCommandExecuted)
+	SERVER_FUNC(OnInstanceTasInputQueueStatus)
 
 private:
 	template<class T>
@@ -88,7 +145,6 @@ private:
 	void ipcReadData(std::shared_ptr<NamedPipe>& channel, std::function<void(const T&)> onDeserialize);
 
 	void onInstanceToServerDataReceived(const DolphinIpcToServerData& data);
-	void onServerToInstanceDataReceived(const DolphinIpcToInstanceData& data);
 
 	bool _isInstance = true;
 	std::shared_ptr<NamedPipe> _instanceToServer = nullptr;
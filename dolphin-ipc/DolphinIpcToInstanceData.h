@@ -30,6 +30,44 @@ enum class DolphinInstanceIpcCall
 	DolphinInstance_ImportGci,
 	DolphinInstance_ReadMemory,
 	DolphinInstance_WriteMemory,
+	DolphinInstance_SubscribeMemoryWatches,
+	DolphinInstance_UnsubscribeMemoryWatches,
+	DolphinInstance_ScanMemory,
+	DolphinInstance_ClearMemoryScan,
+	DolphinInstance_ScanPointerPaths,
+	DolphinInstance_SetSharedRamMapping,
+	DolphinInstance_ReadMemoryTyped,
+	DolphinInstance_WriteMemoryTyped,
+	DolphinInstance_RegisterMemoryTriggers,
+	DolphinInstance_UnregisterMemoryTriggers,
+	DolphinInstance_StartRamDiff,
+	DolphinInstance_StopRamDiff,
+	DolphinInstance_SaveStateToSlot,
+	DolphinInstance_LoadStateFromSlot,
+	DolphinInstance_FreeStateSlots,
+	DolphinInstance_ListStateSlots,
+	DolphinInstance_PersistStateSlot,
+	DolphinInstance_SaveStateToStore,
+	DolphinInstance_LoadStateFromStore,
+	DolphinInstance_CreateSaveStateData,
+	DolphinInstance_LoadSaveStateData,
+	DolphinInstance_ConfigureRewind,
+	DolphinInstance_RewindToFrame,
+	DolphinInstance_FlushMemoryCards,
+	DolphinInstance_ReadMemoryCardImage,
+	DolphinInstance_WriteMemoryCardImage,
+	DolphinInstance_PersistMemoryCard,
+	DolphinInstance_SetStepMode,
+	DolphinInstance_StepFrames,
+	DolphinInstance_ConfigureObservation,
+	DolphinInstance_Step,
+	DolphinInstance_SearchInputs,
+	DolphinInstance_ConfigureStateHash,
+	DolphinInstance_GetStateHash,
+	DolphinInstance_ScheduleCommand,
+	DolphinInstance_ConfigureTasInputQueue,
+	DolphinInstance_QueueTasInputs,
+	DolphinInstance_ClearTasInputQueue,
 };
 
 struct ToInstanceParams_Connect
@@ -66,6 +104,7 @@ struct ToInstanceParams_StartRecordingInput
 {
 	bool _unpauseInstance = true;
 	bool _recordControllers[4] = { true, false, false, false };
+	int _ramHashIntervalFrames = 0;		// Records RAM hashes for desync detection when above zero
 
 	template <class Archive>
 	void serialize(Archive& ar)
@@ -75,6 +114,7 @@ struct ToInstanceParams_StartRecordingInput
 		ar(_recordControllers[1]);
 		ar(_recordControllers[2]);
 		ar(_recordControllers[3]);
+		ar(_ramHashIntervalFrames);
 	}
 };
 
@@ -105,6 +145,8 @@ struct ToInstanceParams_ResumeEmulation
 struct ToInstanceParams_PlayInputs
 {
 	DolphinInputRecording _inputRecording[4];
+	bool _turbo = false;		// Unthrottled, without vsync, frame dumping or audio, until the inputs are exhausted
+	DolphinRamHashTrack _ramHashes;	// From OnInstanceRecordingStopped, verified every interval when not empty
 
 	template <class Archive>
 	void serialize(Archive& ar)
@@ -113,17 +155,23 @@ struct ToInstanceParams_PlayInputs
 		ar(_inputRecording[1]);
 		ar(_inputRecording[2]);
 		ar(_inputRecording[3]);
+		ar(_turbo);
+		ar(_ramHashes);
 	}
 };
 
 struct ToInstanceParams_FrameAdvance
 {
 	int _numFrames = 1;
+	bool _turbo = false;
+	bool _skipLagFrames = false;	// Counts only frames the game polled its controllers on, instead of every emulated frame
 
 	template <class Archive>
 	void serialize(Archive& ar)
 	{
 		ar(_numFrames);
+		ar(_turbo);
+		ar(_skipLagFrames);
 	}
 };
 
@@ -227,6 +275,522 @@ struct ToInstanceParams_WriteMemory
 	}
 };
 
+struct ToInstanceParams_SubscribeMemoryWatches
+{
+	std::vector<DolphinMemoryWatch> _watches;
+	int _sampleIntervalFrames = 1;
+	bool _clearExisting = false;
+
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+		ar(_watches);
+		ar(_sampleIntervalFrames);
+		ar(_clearExisting);
+	}
+};
+
+struct ToInstanceParams_UnsubscribeMemoryWatches
+{
+	// Leave empty to remove every watch
+	std::vector<int> _watchIds;
+
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+		ar(_watchIds);
+	}
+};
+
+struct ToInstanceParams_ScanMemory
+{
+	DolphinValueType _valueType = DolphinValueType::U32;
+	DolphinScanCompareType _compareType = DolphinScanCompareType::Exact;
+	double _value = 0.0;	// Exact value, or lower bound for range scans
+	double _rangeMax = 0.0;	// Upper bound for range scans
+	bool _newScan = false;	// Discard previous candidates and scan every aligned address
+	int _maxResults = 4096;
+
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+		ar(_valueType);
+		ar(_compareType);
+		ar(_value);
+		ar(_rangeMax);
+		ar(_newScan);
+		ar(_maxResults);
+	}
+};
+
+struct ToInstanceParams_ClearMemoryScan
+{
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+	}
+};
+
+struct ToInstanceParams_ScanPointerPaths
+{
+	unsigned int _targetAddress = 0;
+	int _maxDepth = 4;
+	int _maxOffset = 0x1000;
+	// Addresses in this range are treated as static bases. Leave the end at 0 to use the game's static data (up to OS ArenaLo).
+	unsigned int _staticRangeStart = 0x80003100;
+	unsigned int _staticRangeEnd = 0;
+	int _maxResults = 10000;
+
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+		ar(_targetAddress);
+		ar(_maxDepth);
+		ar(_maxOffset);
+		ar(_staticRangeStart);
+		ar(_staticRangeEnd);
+		ar(_maxResults);
+	}
+};
+
+struct ToInstanceParams_SetSharedRamMapping
+{
+	bool _enabled = true;
+	int _publishIntervalFrames = 1;		// Frames between sequence bumps. RAM itself is never copied, readers see it live.
+
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+		ar(_enabled);
+		ar(_publishIntervalFrames);
+	}
+};
+
+// Typed variants of ReadMemory/WriteMemory. Elements are big endian in emulated memory and host endian over IPC,
+// with the swap done by the instance. Results are returned through OnInstanceMemoryRead/OnInstanceMemoryWrite.
+struct ToInstanceParams_ReadMemoryTyped
+{
+	unsigned int _address;
+	std::vector<int> _pointerOffsets;
+	DolphinValueType _valueType = DolphinValueType::U32;
+	int _numberOfElements = 0;
+
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+		ar(_address);
+		ar(_pointerOffsets);
+		ar(_valueType);
+		ar(_numberOfElements);
+	}
+};
+
+struct ToInstanceParams_WriteMemoryTyped
+{
+	std::vector<unsigned char> _bytes;
+	unsigned int _address;
+	std::vector<int> _pointerOffsets;
+	DolphinValueType _valueType = DolphinValueType::U32;
+
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+		ar(_bytes);
+		ar(_address);
+		ar(_pointerOffsets);
+		ar(_valueType);
+	}
+};
+
+struct ToInstanceParams_RegisterMemoryTriggers
+{
+	std::vector<DolphinMemoryTrigger> _triggers;
+	bool _clearExisting = false;
+
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+		ar(_triggers);
+		ar(_clearExisting);
+	}
+};
+
+struct ToInstanceParams_UnregisterMemoryTriggers
+{
+	// Leave empty to remove every trigger
+	std::vector<int> _triggerIds;
+
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+		ar(_triggerIds);
+	}
+};
+
+struct ToInstanceParams_StartRamDiff
+{
+	int _numFrames = 1;			// Number of consecutive frame diffs to report, or 0 to continue until stopped
+	int _blockSize = 32;		// Compare granularity in bytes, rounded up to a multiple of 16
+	bool _includeBytes = true;
+
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+		ar(_numFrames);
+		ar(_blockSize);
+		ar(_includeBytes);
+	}
+};
+
+struct ToInstanceParams_StopRamDiff
+{
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+	}
+};
+
+struct ToInstanceParams_SaveStateToSlot
+{
+	int _slot = 0;
+	int _baseSlot = -1;			// Store only the blocks that differ from this slot, or -1 for a full state
+	int _maxChainDepth = 8;		// Deeper deltas are rebased onto the root of their chain
+
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+		ar(_slot);
+		ar(_baseSlot);
+		ar(_maxChainDepth);
+	}
+};
+
+struct ToInstanceParams_LoadStateFromSlot
+{
+	int _slot = 0;
+
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+		ar(_slot);
+	}
+};
+
+struct ToInstanceParams_FreeStateSlots
+{
+	std::vector<int> _slots;	// Empty frees every slot
+
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+		ar(_slots);
+	}
+};
+
+struct ToInstanceParams_ListStateSlots
+{
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+	}
+};
+
+struct ToInstanceParams_PersistStateSlot
+{
+	int _slot = 0;
+	std::string _filePathNoExtension;
+
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+		ar(_slot);
+		ar(_filePathNoExtension);
+	}
+};
+
+struct ToInstanceParams_SaveStateToStore
+{
+	std::string _storeDirectory;	// Shared by every instance on the host, chunks are deduplicated across all states in it
+	std::string _stateName;
+	unsigned int _chunkSize = 64 * 1024;
+
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+		ar(_storeDirectory);
+		ar(_stateName);
+		ar(_chunkSize);
+	}
+};
+
+struct ToInstanceParams_LoadStateFromStore
+{
+	std::string _storeDirectory;
+	std::string _stateName;
+
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+		ar(_storeDirectory);
+		ar(_stateName);
+	}
+};
+
+struct ToInstanceParams_CreateSaveStateData
+{
+	bool _saveMemoryCards = true;
+	bool _useSharedMemory = true;	// Return payloads as shared memory references, valid until the next call that returns payloads.
+									// Payloads over DolphinPayload::MaxInlineSize, such as the state itself, are always shared.
+
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+		ar(_saveMemoryCards);
+		ar(_useSharedMemory);
+	}
+};
+
+struct ToInstanceParams_LoadSaveStateData
+{
+	DolphinPayload _state;					// Shared by reference when over DolphinPayload::MaxInlineSize, the pipe refuses larger messages
+	DolphinPayload _optionalMemoryCardA;	// Raw card images, left untouched when empty
+	DolphinPayload _optionalMemoryCardB;
+
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+		ar(_state);
+		ar(_optionalMemoryCardA);
+		ar(_optionalMemoryCardB);
+	}
+};
+
+struct ToInstanceParams_ConfigureRewind
+{
+	int _intervalFrames = 30;		// Frames between checkpoints, or 0 to disable rewinding
+	int _maxCheckpoints = 60;		// Bounds memory use, and how far back a rewind can reach
+
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+		ar(_intervalFrames);
+		ar(_maxCheckpoints);
+	}
+};
+
+struct ToInstanceParams_RewindToFrame
+{
+	unsigned long long _frameNumber = 0;
+
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+		ar(_frameNumber);
+	}
+};
+
+struct ToInstanceParams_FlushMemoryCards
+{
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+	}
+};
+
+struct ToInstanceParams_ReadMemoryCardImage
+{
+	DolphinSlot _slot = DolphinSlot::SlotA;
+	bool _useSharedMemory = true;	// Large cards are always shared, a 2043 block card alone fills a whole pipe message
+
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+		ar(_slot);
+		ar(_useSharedMemory);
+	}
+};
+
+struct ToInstanceParams_WriteMemoryCardImage
+{
+	DolphinSlot _slot = DolphinSlot::SlotA;
+	DolphinPayload _image;		// Raw card image, seen by the game the next time the card is inserted
+
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+		ar(_slot);
+		ar(_image);
+	}
+};
+
+struct ToInstanceParams_PersistMemoryCard
+{
+	DolphinSlot _slot = DolphinSlot::SlotA;
+	std::string _filePath;
+
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+		ar(_slot);
+		ar(_filePath);
+	}
+};
+
+// Step mode parks the CPU thread at the first controller poll of each frame, where it answers StepFrames, SetTasInput and memory reads itself
+struct ToInstanceParams_SetStepMode
+{
+	bool _enabled = false;	// Disabling leaves emulation paused
+
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+		ar(_enabled);
+	}
+};
+
+struct ToInstanceParams_StepFrames
+{
+	int _numFrames = 1;
+
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+		ar(_numFrames);
+	}
+};
+
+struct ToInstanceParams_ConfigureObservation
+{
+	std::vector<DolphinMemoryRegion> _memoryRegions;
+	int _framebufferWidth = 0;		// Zero width or height leaves the framebuffer out of observations
+	int _framebufferHeight = 0;
+	bool _framebufferGrayscale = true;
+
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+		ar(_memoryRegions);
+		ar(_framebufferWidth);
+		ar(_framebufferHeight);
+		ar(_framebufferGrayscale);
+	}
+};
+
+// Holds the given inputs for _numFrames frames in step mode, then answers with a single OnInstanceStepCompleted
+struct ToInstanceParams_Step
+{
+	DolphinControllerState _tasInputStates[4];
+	int _numFrames = 1;		// Zero only captures an observation
+
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+		ar(_tasInputStates[0]);
+		ar(_tasInputStates[1]);
+		ar(_tasInputStates[2]);
+		ar(_tasInputStates[3]);
+		ar(_numFrames);
+	}
+};
+
+// Brute forces every combination of the per-frame choices from the current state, entirely inside the instance
+struct ToInstanceParams_SearchInputs
+{
+	int _controllerId = 0;
+	std::vector<DolphinSearchFrame> _frames;		// Frames past the last entry hold its choice
+	int _horizonFrames = 1;
+	std::vector<DolphinSearchObjectiveTerm> _objective;
+	int _topK = 10;
+	unsigned long long _maxCandidates = 0;		// Zero evaluates the whole space
+
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+		ar(_controllerId);
+		ar(_frames);
+		ar(_horizonFrames);
+		ar(_objective);
+		ar(_topK);
+		ar(_maxCandidates);
+	}
+};
+
+// Selects the RAM that makes up the canonical state hash. Unchanged blocks keep their hash between calls, so it stays cheap every frame.
+struct ToInstanceParams_ConfigureStateHash
+{
+	std::vector<DolphinMemoryRegion> _memoryRegions;		// Empty hashes all of MEM1 and MEM2
+	std::vector<DolphinMemoryRegion> _excludedRegions;		// RNG seeds, timers and other bytes that should not tell states apart
+	int _blockSize = 256;
+
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+		ar(_memoryRegions);
+		ar(_excludedRegions);
+		ar(_blockSize);
+	}
+};
+
+struct ToInstanceParams_GetStateHash
+{
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+	}
+};
+
+// Queued TAS inputs override a controller every frame, like hardware input, until ClearTasInputQueue. Configuring also clears.
+struct ToInstanceParams_ConfigureTasInputQueue
+{
+	int _capacityFrames = 600;
+	int _lowWaterFrames = 30;		// OnInstanceTasInputQueueStatus is sent when a queue drains down to this many frames
+
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+		ar(_capacityFrames);
+		ar(_lowWaterFrames);
+	}
+};
+
+// Appends one input per frame to each controller's queue, answered with OnInstanceTasInputQueueStatus
+struct ToInstanceParams_QueueTasInputs
+{
+	DolphinInputRecording _inputs[4];
+
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+		ar(_inputs[0]);
+		ar(_inputs[1]);
+		ar(_inputs[2]);
+		ar(_inputs[3]);
+	}
+};
+
+struct ToInstanceParams_ClearTasInputQueue
+{
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+	}
+};
+
+struct DolphinIpcToInstanceData;
+
+// Runs another call at the first input poll of the given emulated frame, instead of whenever the host loop gets to it.
+// Calls due on the same frame run in the order they were scheduled, and a frame already in the past means the next one.
+struct ToInstanceParams_ScheduleCommand
+{
+	unsigned long long _scheduleId = 0;		// Caller chosen, echoed back by OnInstanceScheduledCommandExecuted
+	unsigned long long _frameNumber = 0;
+	std::shared_ptr<DolphinIpcToInstanceData> _command;
+
+	// Defined after DolphinIpcToInstanceData, which has to be complete by then
+	template <class Archive>
+	void serialize(Archive& ar);
+};
+
 #define TO_INSTANCE_MEMBER(Name) std::shared_ptr<ToInstanceParams_##Name> _params ## Name;
 struct DolphinIpcToInstanceDataParams
 {
@@ -249,6 +813,44 @@ struct DolphinIpcToInstanceDataParams
 	TO_INSTANCE_MEMBER(FormatMemoryCard)
 	TO_INSTANCE_MEMBER(ReadMemory)
 	TO_INSTANCE_MEMBER(WriteMemory)
+	TO_INSTANCE_MEMBER(SubscribeMemoryWatches)
+	TO_INSTANCE_MEMBER(UnsubscribeMemoryWatches)
+	TO_INSTANCE_MEMBER(ScanMemory)
+	TO_INSTANCE_MEMBER(ClearMemoryScan)
+	TO_INSTANCE_MEMBER(ScanPointerPaths)
+	TO_INSTANCE_MEMBER(SetSharedRamMapping)
+	TO_INSTANCE_MEMBER(ReadMemoryTyped)
+	TO_INSTANCE_MEMBER(WriteMemoryTyped)
+	TO_INSTANCE_MEMBER(RegisterMemoryTriggers)
+	TO_INSTANCE_MEMBER(UnregisterMemoryTriggers)
+	TO_INSTANCE_MEMBER(StartRamDiff)
+	TO_INSTANCE_MEMBER(StopRamDiff)
+	TO_INSTANCE_MEMBER(SaveStateToSlot)
+	TO_INSTANCE_MEMBER(LoadStateFromSlot)
+	TO_INSTANCE_MEMBER(FreeStateSlots)
+	TO_INSTANCE_MEMBER(ListStateSlots)
+	TO_INSTANCE_MEMBER(PersistStateSlot)
+	TO_INSTANCE_MEMBER(SaveStateToStore)
+	TO_INSTANCE_MEMBER(LoadStateFromStore)
+	TO_INSTANCE_MEMBER(CreateSaveStateData)
+	TO_INSTANCE_MEMBER(LoadSaveStateData)
+	TO_INSTANCE_MEMBER(ConfigureRewind)
+	TO_INSTANCE_MEMBER(RewindToFrame)
+	TO_INSTANCE_MEMBER(FlushMemoryCards)
+	TO_INSTANCE_MEMBER(ReadMemoryCardImage)
+	TO_INSTANCE_MEMBER(WriteMemoryCardImage)
+	TO_INSTANCE_MEMBER(PersistMemoryCard)
+	TO_INSTANCE_MEMBER(SetStepMode)
+	TO_INSTANCE_MEMBER(StepFrames)
+	TO_INSTANCE_MEMBER(ConfigureObservation)
+	TO_INSTANCE_MEMBER(Step)
+	TO_INSTANCE_MEMBER(SearchInputs)
+	TO_INSTANCE_MEMBER(ConfigureStateHash)
+	TO_INSTANCE_MEMBER(GetStateHash)
+	TO_INSTANCE_MEMBER(ScheduleCommand)
+	TO_INSTANCE_MEMBER(ConfigureTasInputQueue)
+	TO_INSTANCE_MEMBER(QueueTasInputs)
+	TO_INSTANCE_MEMBER(ClearTasInputQueue)
 };
 
 #define TO_INSTANCE_ARCHIVE(Name) case DolphinInstanceIpcCall::DolphinInstance_ ## Name: \
@@ -287,6 +889,58 @@ struct DolphinIpcToInstanceData
 			TO_INSTANCE_ARCHIVE(FormatMemoryCard)
 			TO_INSTANCE_ARCHIVE(ReadMemory)
 			TO_INSTANCE_ARCHIVE(WriteMemory)
+			TO_INSTANCE_ARCHIVE(SubscribeMemoryWatches)
+			TO_INSTANCE_ARCHIVE(UnsubscribeMemoryWatches)
+			TO_INSTANCE_ARCHIVE(ScanMemory)
+			TO_INSTANCE_ARCHIVE(ClearMemoryScan)
+			TO_INSTANCE_ARCHIVE(ScanPointerPaths)
+			TO_INSTANCE_ARCHIVE(SetSharedRamMapping)
+			TO_INSTANCE_ARCHIVE(ReadMemoryTyped)
+			TO_INSTANCE_ARCHIVE(WriteMemoryTyped)
+			TO_INSTANCE_ARCHIVE(RegisterMemoryTriggers)
+			TO_INSTANCE_ARCHIVE(UnregisterMemoryTriggers)
+			TO_INSTANCE_ARCHIVE(StartRamDiff)
+			TO_INSTANCE_ARCHIVE(StopRamDiff)
+			TO_INSTANCE_ARCHIVE(SaveStateToSlot)
+			TO_INSTANCE_ARCHIVE(LoadStateFromSlot)
+			TO_INSTANCE_ARCHIVE(FreeStateSlots)
+			TO_INSTANCE_ARCHIVE(ListStateSlots)
+			TO_INSTANCE_ARCHIVE(PersistStateSlot)
+			TO_INSTANCE_ARCHIVE(SaveStateToStore)
+			TO_INSTANCE_ARCHIVE(LoadStateFromStore)
+			TO_INSTANCE_ARCHIVE(CreateSaveStateData)
+			TO_INSTANCE_ARCHIVE(LoadSaveStateData)
+			TO_INSTANCE_ARCHIVE(ConfigureRewind)
+			TO_INSTANCE_ARCHIVE(RewindToFrame)
+			TO_INSTANCE_ARCHIVE(FlushMemoryCards)
+			TO_INSTANCE_ARCHIVE(ReadMemoryCardImage)
+			TO_INSTANCE_ARCHIVE(WriteMemoryCardImage)
+			TO_INSTANCE_ARCHIVE(PersistMemoryCard)
+			TO_INSTANCE_ARCHIVE(SetStepMode)
+			TO_INSTANCE_ARCHIVE(StepFrames)
+			TO_INSTANCE_ARCHIVE(ConfigureObservation)
+			TO_INSTANCE_ARCHIVE(Step)
+			TO_INSTANCE_ARCHIVE(SearchInputs)
+			TO_INSTANCE_ARCHIVE(ConfigureStateHash)
+			TO_INSTANCE_ARCHIVE(GetStateHash)
+			TO_INSTANCE_ARCHIVE(ScheduleCommand)
+			TO_INSTANCE_ARCHIVE(ConfigureTasInputQueue)
+			TO_INSTANCE_ARCHIVE(QueueTasInputs)
+			TO_INSTANCE_ARCHIVE(ClearTasInputQueue)
 		}
 	}
 };
+
+template <class Archive>
+void ToInstanceParams_ScheduleCommand::serialize(Archive& ar)
+{
+	ar(_scheduleId);
+	ar(_frameNumber);
+
+	if (!_command)
+	{
+		_command = std::make_shared<DolphinIpcToInstanceData>();
+	}
+
+	ar(*_command);
+}
@@ -23,6 +23,22 @@ enum class DolphinServerIpcCall
 	DolphinServer_OnInstanceMemoryRead,
 	DolphinServer_OnInstanceMemoryWrite,
 	DolphinServer_OnInstanceRenderGba,
+	DolphinServer_OnInstanceMemoryWatchChanged,
+	DolphinServer_OnInstanceMemoryScanned,
+	DolphinServer_OnInstancePointerPathsScanned,
+	DolphinServer_OnInstanceSharedRamMapped,
+	DolphinServer_OnInstanceMemoryTriggerFired,
+	DolphinServer_OnInstanceRamDiff,
+	DolphinServer_OnInstanceStateSlotsListed,
+	DolphinServer_OnInstanceStateStored,
+	DolphinServer_OnInstanceSaveStateData,
+	DolphinServer_OnInstanceMemoryCardImage,
+	DolphinServer_OnInstanceStepCompleted,
+	DolphinServer_OnInstanceInputSearchCompleted,
+	DolphinServer_OnInstanceDesyncDetected,
+	DolphinServer_OnInstanceStateHash,
+	DolphinServer_OnInstanceScheduledCommandExecuted,
+	DolphinServer_OnInstanceTasInputQueueStatus,
 };
 
 struct ToServerParams_OnInstanceConnected
@@ -39,11 +55,13 @@ struct ToServerParams_OnInstanceConnected
 struct ToServerParams_OnInstanceCommandCompleted
 {
 	DolphinInstanceIpcCall _completedCommand;
+	float _emulatedFps = 0.0f;	// Achieved speed for PlayInputs and FrameAdvance, zero for other commands
 
 	template <class Archive>
 	void serialize(Archive& ar)
 	{
 		ar(_completedCommand);
+		ar(_emulatedFps);
 	}
 };
 
@@ -52,6 +70,8 @@ struct ToServerParams_OnInstanceHeartbeatAcknowledged
 	bool _isRecording = false;
 	bool _isPaused = false;
 	DolphinControllerState _hardwareInputStates[4];
+	unsigned long long _lagFrameCount = 0;	// Total since boot
+	DolphinLagBitmap _lagFrames;			// Frames since the previous heartbeat
 
 	template <class Archive>
 	void serialize(Archive& ar)
@@ -62,6 +82,8 @@ struct ToServerParams_OnInstanceHeartbeatAcknowledged
 		ar(_hardwareInputStates[1]);
 		ar(_hardwareInputStates[2]);
 		ar(_hardwareInputStates[3]);
+		ar(_lagFrameCount);
+		ar(_lagFrames);
 	}
 };
 
@@ -98,6 +120,8 @@ struct ToServerParams_OnInstanceTerminated
 struct ToServerParams_OnInstanceRecordingStopped
 {
 	DolphinInputRecording _inputRecording[4];
+	DolphinRamHashTrack _ramHashes;
+	DolphinLagBitmap _lagFrames;
 
 	template <class Archive>
 	void serialize(Archive& ar)
@@ -106,6 +130,8 @@ struct ToServerParams_OnInstanceRecordingStopped
 		ar(_inputRecording[1]);
 		ar(_inputRecording[2]);
 		ar(_inputRecording[3]);
+		ar(_ramHashes);
+		ar(_lagFrames);
 	}
 };
 
@@ -166,6 +192,274 @@ struct ToServerParams_OnInstanceRenderGba
 	}
 };
 
+struct ToServerParams_OnInstanceMemoryWatchChanged
+{
+	unsigned long long _frameNumber = 0;
+	std::vector<DolphinMemoryWatchChange> _changes;
+
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+		ar(_frameNumber);
+		ar(_changes);
+	}
+};
+
+struct ToServerParams_OnInstanceMemoryScanned
+{
+	unsigned long long _candidateCount = 0;
+	std::vector<unsigned int> _addresses;	// Truncated to the requested max results
+
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+		ar(_candidateCount);
+		ar(_addresses);
+	}
+};
+
+struct ToServerParams_OnInstancePointerPathsScanned
+{
+	unsigned int _targetAddress = 0;
+	bool _truncated = false;
+	std::vector<DolphinPointerPath> _paths;
+
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+		ar(_targetAddress);
+		ar(_truncated);
+		ar(_paths);
+	}
+};
+
+struct ToServerParams_OnInstanceSharedRamMapped
+{
+	bool _enabled = false;
+	std::string _mappingName;	// Open with SharedRamView using the instance id
+	unsigned int _mem1Size = 0;
+	unsigned int _mem2Size = 0;
+
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+		ar(_enabled);
+		ar(_mappingName);
+		ar(_mem1Size);
+		ar(_mem2Size);
+	}
+};
+
+struct ToServerParams_OnInstanceMemoryTriggerFired
+{
+	unsigned long long _frameNumber = 0;
+	std::vector<int> _triggerIds;
+	bool _paused = false;
+
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+		ar(_frameNumber);
+		ar(_triggerIds);
+		ar(_paused);
+	}
+};
+
+struct ToServerParams_OnInstanceRamDiff
+{
+	// Span bytes carried by one message. Larger diffs arrive as several parts, splitting spans where needed.
+	static constexpr size_t MaxBytesPerMessage = 4 * 1024 * 1024;
+
+	unsigned long long _fromFrame = 0;
+	unsigned long long _toFrame = 0;
+	std::vector<DolphinRamSpan> _spans;
+	bool _isLastPart = true;
+
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+		ar(_fromFrame);
+		ar(_toFrame);
+		ar(_spans);
+		ar(_isLastPart);
+	}
+};
+
+struct ToServerParams_OnInstanceStateSlotsListed
+{
+	std::vector<DolphinStateSlotInfo> _slots;
+	unsigned long long _totalSizeBytes = 0;
+
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+		ar(_slots);
+		ar(_totalSizeBytes);
+	}
+};
+
+struct ToServerParams_OnInstanceStateStored
+{
+	std::string _stateName;
+	bool _success = false;
+	unsigned int _totalChunks = 0;
+	unsigned int _newChunks = 0;				// Chunks that were not already in the store
+	unsigned long long _bytesWritten = 0;
+
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+		ar(_stateName);
+		ar(_success);
+		ar(_totalChunks);
+		ar(_newChunks);
+		ar(_bytesWritten);
+	}
+};
+
+struct ToServerParams_OnInstanceSaveStateData
+{
+	DolphinPayload _state;
+	DolphinPayload _memoryCardA;
+	DolphinPayload _memoryCardB;
+	DolphinInputRecording _inputRecording[4];
+
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+		ar(_state);
+		ar(_memoryCardA);
+		ar(_memoryCardB);
+		ar(_inputRecording[0]);
+		ar(_inputRecording[1]);
+		ar(_inputRecording[2]);
+		ar(_inputRecording[3]);
+	}
+};
+
+struct ToServerParams_OnInstanceMemoryCardImage
+{
+	DolphinSlot _slot = DolphinSlot::SlotA;
+	DolphinPayload _image;
+
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+		ar(_slot);
+		ar(_image);
+	}
+};
+
+struct ToServerParams_OnInstanceStepCompleted
+{
+	unsigned long long _frameNumber = 0;
+	std::vector<std::vector<unsigned char>> _memoryRegions;	// In the order they were configured
+	int _framebufferWidth = 0;
+	int _framebufferHeight = 0;
+	bool _framebufferGrayscale = true;
+	std::vector<unsigned char> _framebuffer;	// One byte per pixel when grayscale, otherwise RGB
+	unsigned long long _stateHash = 0;		// Canonical state hash, zero until ConfigureStateHash has been called
+
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+		ar(_frameNumber);
+		ar(_memoryRegions);
+		ar(_framebufferWidth);
+		ar(_framebufferHeight);
+		ar(_framebufferGrayscale);
+		ar(_framebuffer);
+		ar(_stateHash);
+	}
+};
+
+struct ToServerParams_OnInstanceInputSearchCompleted
+{
+	unsigned long long _candidatesEvaluated = 0;
+	float _candidatesPerSecond = 0.0f;
+	std::vector<DolphinSearchResult> _results;	// Best first
+
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+		ar(_candidatesEvaluated);
+		ar(_candidatesPerSecond);
+		ar(_results);
+	}
+};
+
+// Playback stops and emulation pauses on the first poll whose RAM hash differs from the recording
+struct ToServerParams_OnInstanceDesyncDetected
+{
+	unsigned long long _frameNumber = 0;
+	unsigned long long _pollIndex = 0;		// Input poll since playback started
+	unsigned long long _expectedHash = 0;
+	unsigned long long _actualHash = 0;
+
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+		ar(_frameNumber);
+		ar(_pollIndex);
+		ar(_expectedHash);
+		ar(_actualHash);
+	}
+};
+
+struct ToServerParams_OnInstanceStateHash
+{
+	unsigned long long _frameNumber = 0;
+	unsigned long long _stateHash = 0;		// Zero until ConfigureStateHash has been called
+
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+		ar(_frameNumber);
+		ar(_stateHash);
+	}
+};
+
+// Sent right before a scheduled call runs, so whatever the call itself reports can be matched to the frame it ran on
+struct ToServerParams_OnInstanceScheduledCommandExecuted
+{
+	unsigned long long _scheduleId = 0;
+	DolphinInstanceIpcCall _call = DolphinInstanceIpcCall::Null;
+	unsigned long long _requestedFrame = 0;
+	unsigned long long _executedFrame = 0;
+
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+		ar(_scheduleId);
+		ar(_call);
+		ar(_requestedFrame);
+		ar(_executedFrame);
+	}
+};
+
+struct ToServerParams_OnInstanceTasInputQueueStatus
+{
+	unsigned long long _frameNumber = 0;
+	int _queuedFrames[4] = { 0, 0, 0, 0 };
+	int _droppedInputs[4] = { 0, 0, 0, 0 };		// Inputs from this QueueTasInputs call that did not fit
+	bool _isLowWater = false;					// Sent unprompted because a queue drained down to the low water mark
+
+	template <class Archive>
+	void serialize(Archive& ar)
+	{
+		ar(_frameNumber);
+		ar(_queuedFrames[0]);
+		ar(_queuedFrames[1]);
+		ar(_queuedFrames[2]);
+		ar(_queuedFrames[3]);
+		ar(_droppedInputs[0]);
+		ar(_droppedInputs[1]);
+		ar(_droppedInputs[2]);
+		ar(_droppedInputs[3]);
+		ar(_isLowWater);
+	}
+};
+
 #define TO_SERVER_MEMBER(Name) std::shared_ptr<ToServerParams_##Name> _params ## Name;
 struct DolphinIpcToServerDataParams
 {
@@ -182,6 +476,22 @@ struct DolphinIpcToServerDataParams
 	TO_SERVER_MEMBER(OnInstanceMemoryRead)
 	TO_SERVER_MEMBER(OnInstanceMemoryWrite)
 	TO_SERVER_MEMBER(OnInstanceRenderGba)
+	TO_SERVER_MEMBER(OnInstanceMemoryWatchChanged)
+	TO_SERVER_MEMBER(OnInstanceMemoryScanned)
+	TO_SERVER_MEMBER(OnInstancePointerPathsScanned)
+	TO_SERVER_MEMBER(OnInstanceSharedRamMapped)
+	TO_SERVER_MEMBER(OnInstanceMemoryTriggerFired)
+	TO_SERVER_MEMBER(OnInstanceRamDiff)
+	TO_SERVER_MEMBER(OnInstanceStateSlotsListed)
+	TO_SERVER_MEMBER(OnInstanceStateStored)
+	TO_SERVER_MEMBER(OnInstanceSaveStateData)
+	TO_SERVER_MEMBER(OnInstanceMemoryCardImage)
+	TO_SERVER_MEMBER(OnInstanceStepCompleted)
+	TO_SERVER_MEMBER(OnInstanceInputSearchCompleted)
+	TO_SERVER_MEMBER(OnInstanceDesyncDetected)
+	TO_SERVER_MEMBER(OnInstanceStateHash)
+	TO_SERVER_MEMBER(OnInstanceScheduledCommandExecuted)
+	TO_SERVER_MEMBER(OnInstanceTasInputQueueStatus)
 };
 
 #define TO_SERVER_ARCHIVE(Name) case DolphinServerIpcCall::DolphinServer_ ## Name: \
@@ -214,6 +524,22 @@ struct DolphinIpcToServerData
 			TO_SERVER_ARCHIVE(OnInstanceMemoryRead)
 			TO_SERVER_ARCHIVE(OnInstanceMemoryWrite)
 			TO_SERVER_ARCHIVE(OnInstanceRenderGba)
+			TO_SERVER_ARCHIVE(OnInstanceMemoryWatchChanged)
+			TO_SERVER_ARCHIVE(OnInstanceMemoryScanned)
+			TO_SERVER_ARCHIVE(OnInstancePointerPathsScanned)
+			TO_SERVER_ARCHIVE(OnInstanceSharedRamMapped)
+			TO_SERVER_ARCHIVE(OnInstanceMemoryTriggerFired)
+			TO_SERVER_ARCHIVE(OnInstanceRamDiff)
+			TO_SERVER_ARCHIVE(OnInstanceStateSlotsListed)
+			TO_SERVER_ARCHIVE(OnInstanceStateStored)
+			TO_SERVER_ARCHIVE(OnInstanceSaveStateData)
+			TO_SERVER_ARCHIVE(OnInstanceMemoryCardImage)
+			TO_SERVER_ARCHIVE(OnInstanceStepCompleted)
+			TO_SERVER_ARCHIVE(OnInstanceInputSearchCompleted)
+			TO_SERVER_ARCHIVE(OnInstanceDesyncDetected)
+			TO_SERVER_ARCHIVE(OnInstanceStateHash)
+			TO_SERVER_ARCHIVE(OnInstanceScheduledCommandExecuted)
+			TO_SERVER_ARCHIVE(OnInstanceTasInputQueueStatus)
 		}
 	}
 };
@@ -57,6 +57,13 @@ NamedPipe::~NamedPipe()
 
 bool NamedPipe::send(std::string& sData)
 {
+    // The reader could only take this in pieces, and the pipe buffer would not hold it anyway
+    if (sData.size() > MaxMessageSize)
+    {
+        std::cout << "WriteFile skipped: message of " << sData.size() << " bytes exceeds " << MaxMessageSize << std::endl;
+        return false;
+    }
+
     DWORD bytesWritten;
     BOOL bResult = ::WriteFile(
         m_hPipe,
@@ -78,51 +85,45 @@ bool NamedPipe::recv(std::string& sData)
 {
     sData.clear();
 
-    DWORD bytesRead = 0;
-    BOOL bFinishedRead = FALSE;
-    int readBufferIndex = 0;
+    DWORD bytesAvailable = 0;
+    bool peak = ::PeekNamedPipe(
+        m_hPipe,
+        NULL,
+        0,
+        NULL,
+        &bytesAvailable,
+        0);
 
-    do
+    if (!peak || bytesAvailable == 0)
     {
-        bool peak = ::PeekNamedPipe(
-            m_hPipe,
-            &m_buffer[readBufferIndex],
-            (DWORD)m_buffer.size(),
-            &bytesRead,
-            0,
-            0);
+        return false;
+    }
 
-        if (!peak || bytesRead == 0)
-        {
-            return false;
-        }
+    BOOL bFinishedRead = FALSE;
 
+    // A message larger than the buffer comes back in several reads, all but the last failing with ERROR_MORE_DATA
+    do
+    {
+        DWORD bytesRead = 0;
         bFinishedRead = ::ReadFile(
             m_hPipe,
-            &m_buffer[readBufferIndex],
+            m_buffer.data(),
             (DWORD)m_buffer.size(),
             &bytesRead,
             NULL);
 
         if (!bFinishedRead && ERROR_MORE_DATA != GetLastError())
         {
-            bFinishedRead = FALSE;
-            break;
+            std::cout << "ReadFile failed" << GetLastError() << std::endl;
+            sData.clear();
+            return false;
         }
 
-        readBufferIndex += bytesRead;
+        sData.append(m_buffer.data(), bytesRead);
 
     } while (!bFinishedRead);
 
-    if (bFinishedRead == FALSE || 0 == bytesRead)
-    {
-        std::cout << "ReadFile failed" << GetLastError() << std::endl;
-        return false;
-    }
-    
-    sData.append(m_buffer.data(), bytesRead);
-
-    return true;
+    return !sData.empty();
 }
 
 void NamedPipe::close()
@@ -10,6 +10,9 @@ public:
     NamedPipe(std::string& sName, bool isOwner);
     virtual ~NamedPipe(void);
 
+    // Largest message either end will pass, larger payloads must go through shared memory instead
+    static constexpr size_t MaxMessageSize = 16777216;
+
     bool send(std::string& sData);
     bool recv(std::string& sData);
 
@@ -22,5 +25,5 @@ private:
     bool m_hasConnected = false;
 
     // 16MB of a buffer. This needs to be large enough to hold an entire frame buffer, since rendering messages may be passed.
-    std::vector<char> m_buffer = std::vector<char>(16777216);
+    std::vector<char> m_buffer = std::vector<char>(MaxMessageSize);
 };
@@ -6,8 +6,10 @@
 #include "external/cereal/types/vector.hpp"
 #undef __GNUC__
 
+#include <algorithm>
 #include <functional>
 #include <numeric>
+#include <string>
 
 template <typename T, typename U>
 bool AllEqual(const T& t, const U& u)
@@ -367,3 +369,294 @@ private:
         return std::accumulate(analogInputs.begin(), analogInputs.end(), 0, [](int sum, const AnalogRunLengthEncoded& curr) { return sum + curr.Length; });
     }
 };
+
+struct DolphinMemoryWatch
+{
+    int Id = 0;                         // Caller chosen identifier, echoed back in change notifications
+    unsigned int Address = 0;
+    std::vector<int> PointerOffsets;    // Optional pointer chain, re-resolved every sample
+    int NumberOfBytes = 0;
+
+    template <class Archive>
+    void serialize(Archive& ar)
+    {
+        ar(Id);
+        ar(Address);
+        ar(PointerOffsets);
+        ar(NumberOfBytes);
+    }
+};
+
+struct DolphinMemoryWatchChange
+{
+    int Id = 0;
+    unsigned int ResolvedAddress = 0;
+    std::vector<unsigned char> Bytes;   // Empty if the resolved range is not readable
+
+    template <class Archive>
+    void serialize(Archive& ar)
+    {
+        ar(Id);
+        ar(ResolvedAddress);
+        ar(Bytes);
+    }
+};
+
+enum class DolphinValueType
+{
+    U8,
+    U16,
+    U32,
+    F32,
+    F64,
+};
+
+inline int GetValueTypeSize(DolphinValueType valueType)
+{
+    switch (valueType)
+    {
+        case DolphinValueType::U8: return 1;
+        case DolphinValueType::U16: return 2;
+        case DolphinValueType::F64: return 8;
+        default: case DolphinValueType::U32: case DolphinValueType::F32: return 4;
+    }
+}
+
+enum class DolphinScanCompareType
+{
+    Exact,
+    Range,
+    Changed,
+    Unchanged,
+    Increased,
+    Decreased,
+};
+
+struct DolphinPointerPath
+{
+    unsigned int BaseAddress = 0;       // Static address holding the first pointer
+    std::vector<int> PointerOffsets;    // Offsets in the same order as ReadMemory/WriteMemory expect them
+
+    template <class Archive>
+    void serialize(Archive& ar)
+    {
+        ar(BaseAddress);
+        ar(PointerOffsets);
+    }
+};
+
+enum class DolphinCompareOperator
+{
+    Equal,
+    NotEqual,
+    Less,
+    LessEqual,
+    Greater,
+    GreaterEqual,
+};
+
+struct DolphinMemoryTrigger
+{
+    int Id = 0;
+    unsigned int Address = 0;
+    std::vector<int> PointerOffsets;
+    DolphinValueType ValueType = DolphinValueType::U32;
+    DolphinCompareOperator Operator = DolphinCompareOperator::Equal;
+    double Value = 0.0;
+    bool PauseOnMatch = true;       // Pause on the exact frame the condition becomes true, otherwise only notify
+    bool RemoveOnMatch = false;
+
+    template <class Archive>
+    void serialize(Archive& ar)
+    {
+        ar(Id);
+        ar(Address);
+        ar(PointerOffsets);
+        ar(ValueType);
+        ar(Operator);
+        ar(Value);
+        ar(PauseOnMatch);
+        ar(RemoveOnMatch);
+    }
+};
+
+struct DolphinMemoryRegion
+{
+    unsigned int Address = 0;
+    std::vector<int> PointerOffsets;    // Optional pointer chain, re-resolved every capture
+    int NumberOfBytes = 0;
+
+    template <class Archive>
+    void serialize(Archive& ar)
+    {
+        ar(Address);
+        ar(PointerOffsets);
+        ar(NumberOfBytes);
+    }
+};
+
+// Input choices for one frame of an input search. Every button choice is tried with every stick sector.
+struct DolphinSearchFrame
+{
+    std::vector<DolphinControllerState> ButtonChoices;  // Empty tries a single neutral input
+    int StickSectors = 0;               // Main stick directions spread evenly around the circle, zero keeps each choice's own stick
+    unsigned char StickMagnitude = 127; // Distance of each sector from the stick centre
+    bool IncludeStickNeutral = false;   // Also try the centred stick alongside the sectors
+
+    template <class Archive>
+    void serialize(Archive& ar)
+    {
+        ar(ButtonChoices);
+        ar(StickSectors);
+        ar(StickMagnitude);
+        ar(IncludeStickNeutral);
+    }
+};
+
+// A candidate's score is the weighted sum of these values at the end of the horizon, higher is better
+struct DolphinSearchObjectiveTerm
+{
+    unsigned int Address = 0;
+    std::vector<int> PointerOffsets;
+    DolphinValueType ValueType = DolphinValueType::F32;
+    double Weight = 1.0;                // Negative to minimize
+
+    template <class Archive>
+    void serialize(Archive& ar)
+    {
+        ar(Address);
+        ar(PointerOffsets);
+        ar(ValueType);
+        ar(Weight);
+    }
+};
+
+struct DolphinSearchResult
+{
+    double Score = 0.0;
+    std::vector<DolphinControllerState> Inputs;     // One per frame of the horizon
+
+    template <class Archive>
+    void serialize(Archive& ar)
+    {
+        ar(Score);
+        ar(Inputs);
+    }
+};
+
+// RAM hashes taken every IntervalFrames input polls while recording, so playback can find the first frame that diverged
+struct DolphinRamHashTrack
+{
+    int IntervalFrames = 0;
+    std::vector<unsigned long long> Hashes;     // Hashes[i] was taken at poll i * IntervalFrames
+
+    template <class Archive>
+    void serialize(Archive& ar)
+    {
+        ar(IntervalFrames);
+        ar(Hashes);
+    }
+};
+
+// One bit per emulated frame from StartFrame on, set for lag frames: frames on which the game never polled its controllers
+struct DolphinLagBitmap
+{
+    unsigned long long StartFrame = 0;
+    unsigned long long FrameCount = 0;
+    std::vector<unsigned char> Bits;
+
+    bool IsLagFrame(unsigned long long frame) const
+    {
+        if (frame < StartFrame || frame >= StartFrame + FrameCount)
+        {
+            return false;
+        }
+
+        unsigned long long index = frame - StartFrame;
+        return (Bits[index / 8] & (1 << (index % 8))) != 0;
+    }
+
+    void PushFrame(bool isLagFrame)
+    {
+        if (FrameCount % 8 == 0)
+        {
+            Bits.push_back(0);
+        }
+
+        if (isLagFrame)
+        {
+            Bits.back() |= (unsigned char)(1 << (FrameCount % 8));
+        }
+
+        FrameCount++;
+    }
+
+    // Drops every frame from the given one on, for when emulation jumps back to an earlier frame
+    void Truncate(unsigned long long frame)
+    {
+        FrameCount = frame > StartFrame ? std::min(FrameCount, frame - StartFrame) : 0;
+        Bits.resize((FrameCount + 7) / 8);
+
+        if (FrameCount % 8 != 0)
+        {
+            Bits.back() &= (unsigned char)((1 << (FrameCount % 8)) - 1);
+        }
+    }
+
+    template <class Archive>
+    void serialize(Archive& ar)
+    {
+        ar(StartFrame);
+        ar(FrameCount);
+        ar(Bits);
+    }
+};
+
+struct DolphinRamSpan
+{
+    unsigned int Address = 0;
+    unsigned int Size = 0;
+    std::vector<unsigned char> Bytes;   // New contents of the span, empty if bytes were not requested
+
+    template <class Archive>
+    void serialize(Archive& ar)
+    {
+        ar(Address);
+        ar(Size);
+        ar(Bytes);
+    }
+};
+
+struct DolphinStateSlotInfo
+{
+    int Slot = 0;
+    unsigned long long SizeBytes = 0;
+    unsigned long long FrameNumber = 0;     // Movie frame the state was captured on
+    int BaseSlot = -1;                      // Slot this one is stored as a delta against, or -1 for a full state
+
+    template <class Archive>
+    void serialize(Archive& ar)
+    {
+        ar(Slot);
+        ar(SizeBytes);
+        ar(FrameNumber);
+        ar(BaseSlot);
+    }
+};
+
+// A block of bytes carried either inline in the message, or by reference to a SharedPayloadBuffer mapping
+struct DolphinPayload
+{
+    // Larger payloads always go through shared memory, so that a message carrying a few of them stays within the pipe's limit
+    static constexpr size_t MaxInlineSize = 4 * 1024 * 1024;
+
+    std::vector<unsigned char> Bytes;
+    std::string SharedMappingName;          // Used instead of Bytes when not empty
+
+    template <class Archive>
+    void serialize(Archive& ar)
+    {
+        ar(Bytes);
+        ar(SharedMappingName);
+    }
+};
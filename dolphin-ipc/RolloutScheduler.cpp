@@ -0,0 +1,519 @@
+#include "RolloutScheduler.h"
+
+#include "DolphinIpcHandlerBase.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace
+{
+    constexpr auto HeartbeatInterval = std::chrono::seconds(1);
+    constexpr auto UnresponsiveTimeout = std::chrono::seconds(10);
+    constexpr auto PollInterval = std::chrono::microseconds(100);
+}
+
+// Server side connection to one instance. Everything except the queue bookkeeping runs on the worker's own thread, which
+// is also the only thread pumping this connection.
+class RolloutScheduler::Worker : public DolphinIpcHandlerBase
+{
+public:
+    Worker(const std::string& instanceId, int stateSlots, const std::atomic<bool>& isStopping);
+
+    // Returns false if the instance crashed or stopped responding, in which case the job did not run to completion
+    bool run(const RolloutJob& job, int slot, bool isSlotLoaded, const std::shared_ptr<const ToInstanceParams_ConfigureStateHash>& stateHashConfig, RolloutResult& outResult);
+
+    int findStateSlot(const std::string& saveStatePath) const;
+    int acquireStateSlot(const std::string& saveStatePath, bool& outIsLoaded);
+    size_t getLoad() const { return _queue.size() + (_isBusy ? 1 : 0); }
+
+    // Guarded by the scheduler mutex
+    std::string _instanceId;
+    std::deque<RolloutJob> _queue;
+    bool _isAlive = true;
+    bool _isBusy = false;
+
+protected:
+    SERVER_FUNC_OVERRIDE(OnInstanceCommandCompleted)
+    SERVER_FUNC_OVERRIDE(OnInstanceHeartbeatAcknowledged)
+    SERVER_FUNC_OVERRIDE(OnInstanceLogOutput)
+    SERVER_FUNC_OVERRIDE(OnInstanceTerminated)
+    SERVER_FUNC_OVERRIDE(OnInstanceMemoryRead)
+    SERVER_FUNC_OVERRIDE(OnInstanceStateHash)
+
+private:
+    bool sendAndWait(const DolphinIpcToInstanceData& data);
+
+    const std::atomic<bool>& _isStopping;
+
+    // Starting state held in each instance side state slot, with a use counter for least recently used eviction
+    std::vector<std::string> _slotStates;
+    std::vector<unsigned long long> _slotLastUse;
+    unsigned long long _slotUseCounter = 0;
+
+    DolphinInstanceIpcCall _awaitedCall = DolphinInstanceIpcCall::Null;
+    bool _isAwaitedCallComplete = false;
+    bool _isTerminated = false;
+    std::chrono::steady_clock::time_point _lastSignOfLife;
+    std::vector<unsigned char> _lastMemoryRead;
+    unsigned long long _lastStateHash = 0;
+    std::shared_ptr<const ToInstanceParams_ConfigureStateHash> _appliedStateHashConfig;
+};
+
+RolloutScheduler::Worker::Worker(const std::string& instanceId, int stateSlots, const std::atomic<bool>& isStopping)
+    : _instanceId(instanceId), _isStopping(isStopping), _slotStates(std::max(stateSlots, 1)), _slotLastUse(std::max(stateSlots, 1))
+{
+    initializeChannels(instanceId, false);
+}
+
+int RolloutScheduler::Worker::findStateSlot(const std::string& saveStatePath) const
+{
+    auto found = std::find(_slotStates.begin(), _slotStates.end(), saveStatePath);
+
+    return found == _slotStates.end() ? -1 : int(found - _slotStates.begin());
+}
+
+int RolloutScheduler::Worker::acquireStateSlot(const std::string& saveStatePath, bool& outIsLoaded)
+{
+    int slot = findStateSlot(saveStatePath);
+    outIsLoaded = slot >= 0;
+
+    if (!outIsLoaded)
+    {
+        slot = int(std::min_element(_slotLastUse.begin(), _slotLastUse.end()) - _slotLastUse.begin());
+        _slotStates[slot] = saveStatePath;
+    }
+
+    _slotLastUse[slot] = ++_slotUseCounter;
+
+    return slot;
+}
+
+bool RolloutScheduler::Worker::run(const RolloutJob& job, int slot, bool isSlotLoaded, const std::shared_ptr<const ToInstanceParams_ConfigureStateHash>& stateHashConfig, RolloutResult& outResult)
+{
+    outResult._jobId = job._id;
+    outResult._attempts = job._attempts;
+    outResult._instanceId = _instanceId;
+
+    if (stateHashConfig && stateHashConfig != _appliedStateHashConfig)
+    {
+        CREATE_TO_INSTANCE_DATA(ConfigureStateHash, ipcData, data)
+        *data = *stateHashConfig;
+
+        if (!sendAndWait(ipcData))
+        {
+            return false;
+        }
+
+        _appliedStateHashConfig = stateHashConfig;
+    }
+
+    if (isSlotLoaded)
+    {
+        CREATE_TO_INSTANCE_DATA(LoadStateFromSlot, ipcData, data)
+        data->_slot = slot;
+
+        if (!sendAndWait(ipcData))
+        {
+            return false;
+        }
+    }
+    else
+    {
+        // Load from disk once, then keep the state in a slot so later rollouts from it skip the file entirely
+        CREATE_TO_INSTANCE_DATA(LoadSaveState, loadData, load)
+        load->_saveFilePath = job._saveStatePath;
+
+        CREATE_TO_INSTANCE_DATA(SaveStateToSlot, saveData, save)
+        save->_slot = slot;
+
+        if (!sendAndWait(loadData) || !sendAndWait(saveData))
+        {
+            return false;
+        }
+    }
+
+    if (std::any_of(std::begin(job._inputRecording), std::end(job._inputRecording), [](const DolphinInputRecording& recording) { return recording.Size() > 0; }))
+    {
+        CREATE_TO_INSTANCE_DATA(PlayInputs, ipcData, data)
+        std::copy(std::begin(job._inputRecording), std::end(job._inputRecording), data->_inputRecording);
+        data->_turbo = job._turbo;
+
+        if (!sendAndWait(ipcData))
+        {
+            return false;
+        }
+    }
+
+    outResult._memoryReads.reserve(job._memoryReads.size());
+
+    for (const DolphinMemoryRegion& region : job._memoryReads)
+    {
+        CREATE_TO_INSTANCE_DATA(ReadMemory, ipcData, data)
+        data->_address = region.Address;
+        data->_pointerOffsets = region.PointerOffsets;
+        data->_numberOfBytes = region.NumberOfBytes;
+
+        if (!sendAndWait(ipcData))
+        {
+            return false;
+        }
+
+        outResult._memoryReads.push_back(std::move(_lastMemoryRead));
+    }
+
+    if (stateHashConfig)
+    {
+        CREATE_TO_INSTANCE_DATA(GetStateHash, ipcData, data)
+
+        if (!sendAndWait(ipcData))
+        {
+            return false;
+        }
+
+        outResult._stateHash = _lastStateHash;
+    }
+
+    outResult._success = true;
+
+    return true;
+}
+
+bool RolloutScheduler::Worker::sendAndWait(const DolphinIpcToInstanceData& data)
+{
+    _awaitedCall = data._call;
+    _isAwaitedCallComplete = false;
+    _lastSignOfLife = std::chrono::steady_clock::now();
+
+    ipcSendToInstance(data);
+
+    auto lastHeartbeat = _lastSignOfLife;
+
+    while (!_isAwaitedCallComplete)
+    {
+        updateIpcListen();
+
+        if (_isAwaitedCallComplete)
+        {
+            break;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+
+        if (_isTerminated || _isStopping || now - _lastSignOfLife > UnresponsiveTimeout)
+        {
+            return false;
+        }
+
+        // Long input playbacks only complete at the end, so heartbeats are what tell a busy instance from a hung one
+        if (now - lastHeartbeat > HeartbeatInterval)
+        {
+            CREATE_TO_INSTANCE_DATA(Heartbeat, heartbeatData, heartbeat)
+            heartbeat->_shouldUseHardwareController = false;
+            ipcSendToInstance(heartbeatData);
+            lastHeartbeat = now;
+        }
+
+        std::this_thread::sleep_for(PollInterval);
+    }
+
+    return true;
+}
+
+SERVER_FUNC_BODY(RolloutScheduler::Worker, OnInstanceCommandCompleted, params)
+{
+    _lastSignOfLife = std::chrono::steady_clock::now();
+
+    if (params._completedCommand == _awaitedCall)
+    {
+        _isAwaitedCallComplete = true;
+    }
+}
+
+SERVER_FUNC_BODY(RolloutScheduler::Worker, OnInstanceHeartbeatAcknowledged, params)
+{
+    _lastSignOfLife = std::chrono::steady_clock::now();
+}
+
+SERVER_FUNC_BODY(RolloutScheduler::Worker, OnInstanceLogOutput, params)
+{
+    _lastSignOfLife = std::chrono::steady_clock::now();
+}
+
+SERVER_FUNC_BODY(RolloutScheduler::Worker, OnInstanceTerminated, params)
+{
+    _isTerminated = true;
+}
+
+SERVER_FUNC_BODY(RolloutScheduler::Worker, OnInstanceMemoryRead, params)
+{
+    _lastSignOfLife = std::chrono::steady_clock::now();
+    _lastMemoryRead = params._bytes;
+}
+
+SERVER_FUNC_BODY(RolloutScheduler::Worker, OnInstanceStateHash, params)
+{
+    _lastSignOfLife = std::chrono::steady_clock::now();
+    _lastStateHash = params._stateHash;
+}
+
+RolloutScheduler::RolloutScheduler(std::function<void(const RolloutResult&)> onResult, int maxAttempts, int stateSlotsPerInstance)
+    : _onResult(std::move(onResult)), _maxAttempts(std::max(maxAttempts, 1)), _stateSlotsPerInstance(std::max(stateSlotsPerInstance, 1))
+{
+}
+
+RolloutScheduler::~RolloutScheduler()
+{
+    // Outstanding rollouts are abandoned, a worker in the middle of one gives up at its next poll
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _isStopping = true;
+    }
+
+    _workCondition.notify_all();
+
+    for (std::thread& thread : _threads)
+    {
+        if (thread.joinable())
+        {
+            thread.join();
+        }
+    }
+}
+
+void RolloutScheduler::addInstance(const std::string& instanceId)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    _workers.push_back(std::make_unique<Worker>(instanceId, _stateSlotsPerInstance, _isStopping));
+    _threads.emplace_back(&RolloutScheduler::workerLoop, this, _workers.back().get());
+}
+
+void RolloutScheduler::configureStateHash(std::vector<DolphinMemoryRegion> memoryRegions, std::vector<DolphinMemoryRegion> excludedRegions, TranspositionTable* transpositionTable)
+{
+    auto config = std::make_shared<ToInstanceParams_ConfigureStateHash>();
+    config->_memoryRegions = std::move(memoryRegions);
+    config->_excludedRegions = std::move(excludedRegions);
+
+    // Workers pick the new configuration up before their next rollout
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stateHashConfig = std::move(config);
+    _transpositionTable = transpositionTable;
+}
+
+unsigned long long RolloutScheduler::submit(RolloutJob job)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    job._id = _nextJobId++;
+    job._attempts = 0;
+    unsigned long long jobId = job._id;
+
+    _pendingJobs++;
+    enqueue(std::move(job));
+
+    return jobId;
+}
+
+void RolloutScheduler::waitForIdle()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _idleCondition.wait(lock, [this] { return _pendingJobs == 0; });
+}
+
+size_t RolloutScheduler::getLiveInstanceCount()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    return size_t(std::count_if(_workers.begin(), _workers.end(), [](const std::unique_ptr<Worker>& worker) { return worker->_isAlive; }));
+}
+
+// Called with _mutex held
+void RolloutScheduler::enqueue(RolloutJob job)
+{
+    Worker* leastLoaded = nullptr;
+    Worker* leastLoadedWithState = nullptr;
+
+    for (const std::unique_ptr<Worker>& worker : _workers)
+    {
+        if (!worker->_isAlive)
+        {
+            continue;
+        }
+
+        if (!leastLoaded || worker->getLoad() < leastLoaded->getLoad())
+        {
+            leastLoaded = worker.get();
+        }
+
+        if (worker->findStateSlot(job._saveStatePath) >= 0 && (!leastLoadedWithState || worker->getLoad() < leastLoadedWithState->getLoad()))
+        {
+            leastLoadedWithState = worker.get();
+        }
+    }
+
+    // Affinity wins unless it would leave the job queued well behind an instance that is nearly idle. Stealing evens out the rest.
+    static const size_t AffinityLoadSlack = 2;
+    Worker* target = leastLoadedWithState && leastLoadedWithState->getLoad() <= leastLoaded->getLoad() + AffinityLoadSlack ? leastLoadedWithState : leastLoaded;
+
+    if (target)
+    {
+        target->_queue.push_back(std::move(job));
+    }
+    else
+    {
+        _unassignedJobs.push_back(std::move(job));
+    }
+
+    _workCondition.notify_all();
+}
+
+// Called with _mutex held
+bool RolloutScheduler::takeJob(Worker* worker, RolloutJob& outJob)
+{
+    if (!worker->_queue.empty())
+    {
+        outJob = std::move(worker->_queue.front());
+        worker->_queue.pop_front();
+        return true;
+    }
+
+    if (!_unassignedJobs.empty())
+    {
+        outJob = std::move(_unassignedJobs.front());
+        _unassignedJobs.pop_front();
+        return true;
+    }
+
+    // Only steal from busy workers, so an idle worker that was just handed a job for its cached state gets to run it
+    Worker* victim = nullptr;
+
+    for (const std::unique_ptr<Worker>& other : _workers)
+    {
+        if (other.get() != worker && other->_isBusy && !other->_queue.empty() && (!victim || other->_queue.size() > victim->_queue.size()))
+        {
+            victim = other.get();
+        }
+    }
+
+    if (!victim)
+    {
+        return false;
+    }
+
+    // Steal from the back, preferring a job whose starting state this worker already holds
+    auto stolen = std::find_if(victim->_queue.rbegin(), victim->_queue.rend(), [worker](const RolloutJob& job) { return worker->findStateSlot(job._saveStatePath) >= 0; });
+    auto stolenIt = stolen == victim->_queue.rend() ? victim->_queue.end() - 1 : std::prev(stolen.base());
+
+    outJob = std::move(*stolenIt);
+    victim->_queue.erase(stolenIt);
+
+    return true;
+}
+
+void RolloutScheduler::workerLoop(Worker* worker)
+{
+    while (true)
+    {
+        RolloutJob job;
+        int slot = 0;
+        bool isSlotLoaded = false;
+        std::shared_ptr<const ToInstanceParams_ConfigureStateHash> stateHashConfig;
+        TranspositionTable* transpositionTable = nullptr;
+
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _workCondition.wait(lock, [&] { return _isStopping || takeJob(worker, job); });
+
+            if (_isStopping)
+            {
+                return;
+            }
+
+            worker->_isBusy = true;
+            slot = worker->acquireStateSlot(job._saveStatePath, isSlotLoaded);
+            stateHashConfig = _stateHashConfig;
+            transpositionTable = _transpositionTable;
+        }
+
+        job._attempts++;
+
+        RolloutResult result;
+
+        if (!worker->run(job, slot, isSlotLoaded, stateHashConfig, result))
+        {
+            retireWorker(worker, std::move(job));
+            return;
+        }
+
+        if (stateHashConfig && transpositionTable)
+        {
+            result._isTransposition = !transpositionTable->tryVisit(result._stateHash, { job._id, job._depth });
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            worker->_isBusy = false;
+        }
+
+        finishJob(result);
+    }
+}
+
+void RolloutScheduler::retireWorker(Worker* worker, RolloutJob failedJob)
+{
+    RolloutResult failedResult;
+    bool hasFailed = false;
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        worker->_isAlive = false;
+        worker->_isBusy = false;
+
+        if (_isStopping)
+        {
+            return;
+        }
+
+        // Queued jobs never started on this instance, so they move on without using up an attempt
+        std::deque<RolloutJob> orphanedJobs = std::move(worker->_queue);
+        worker->_queue.clear();
+
+        for (RolloutJob& job : orphanedJobs)
+        {
+            enqueue(std::move(job));
+        }
+
+        if (failedJob._attempts < _maxAttempts)
+        {
+            enqueue(std::move(failedJob));
+        }
+        else
+        {
+            failedResult._jobId = failedJob._id;
+            failedResult._attempts = failedJob._attempts;
+            failedResult._instanceId = worker->_instanceId;
+            hasFailed = true;
+        }
+    }
+
+    if (hasFailed)
+    {
+        finishJob(failedResult);
+    }
+}
+
+void RolloutScheduler::finishJob(const RolloutResult& result)
+{
+    if (_onResult)
+    {
+        _onResult(result);
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (--_pendingJobs == 0)
+    {
+        _idleCondition.notify_all();
+    }
+}
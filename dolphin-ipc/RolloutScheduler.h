@@ -0,0 +1,84 @@
+#pragma once
+// Fans "load state, play inputs, read memory" rollouts out across a pool of already launched instances. Each instance has a
+// worker thread and a job queue. Idle workers steal from the busiest queue, and jobs prefer instances that already hold their
+// starting state in an in-memory state slot. A job whose instance dies is retried on another instance.
+
+#include "IpcStructs.h"
+#include "TranspositionTable.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct RolloutJob
+{
+	unsigned long long _id = 0;					// Assigned by submit
+	std::string _saveStatePath;					// Starting state, also the key for instance affinity
+	DolphinInputRecording _inputRecording[4];
+	std::vector<DolphinMemoryRegion> _memoryReads;	// Read after the inputs are exhausted
+	bool _turbo = true;
+	int _depth = 0;								// Search depth of the state the rollout ends on, for the transposition table
+	int _attempts = 0;
+};
+
+struct RolloutResult
+{
+	unsigned long long _jobId = 0;
+	bool _success = false;						// False once every attempt was lost to a crashed or unresponsive instance
+	int _attempts = 0;
+	std::string _instanceId;					// Instance that ran the last attempt
+	std::vector<std::vector<unsigned char>> _memoryReads;
+	unsigned long long _stateHash = 0;			// Canonical hash of the final state, zero unless configureStateHash was called
+	bool _isTransposition = false;				// The final state was already reached by another rollout at the same or lower depth
+};
+
+struct ToInstanceParams_ConfigureStateHash;
+
+class RolloutScheduler
+{
+public:
+	// onResult is invoked from worker threads, in completion order rather than submission order
+	RolloutScheduler(std::function<void(const RolloutResult&)> onResult, int maxAttempts = 3, int stateSlotsPerInstance = 8);
+	~RolloutScheduler();
+
+	// Connects to an instance launched with the given id. Instances can be added while rollouts are running, for example to
+	// replace one that crashed.
+	void addInstance(const std::string& instanceId);
+	// Hashes the final state of every rollout submitted from here on, and records it in the table if one is given.
+	// Rollouts ending on an already visited state are flagged in their result, so the caller can skip expanding them.
+	void configureStateHash(std::vector<DolphinMemoryRegion> memoryRegions, std::vector<DolphinMemoryRegion> excludedRegions, TranspositionTable* transpositionTable);
+	unsigned long long submit(RolloutJob job);
+	void waitForIdle();
+	size_t getLiveInstanceCount();
+
+private:
+	class Worker;
+
+	void workerLoop(Worker* worker);
+	bool takeJob(Worker* worker, RolloutJob& outJob);
+	void enqueue(RolloutJob job);
+	void retireWorker(Worker* worker, RolloutJob failedJob);
+	void finishJob(const RolloutResult& result);
+
+	std::function<void(const RolloutResult&)> _onResult;
+	int _maxAttempts = 3;
+	int _stateSlotsPerInstance = 8;
+	std::shared_ptr<const ToInstanceParams_ConfigureStateHash> _stateHashConfig;	// Guarded by _mutex, replaced rather than modified
+	TranspositionTable* _transpositionTable = nullptr;
+
+	std::mutex _mutex;							// Guards the worker list, every queue and the pending count
+	std::condition_variable _workCondition;
+	std::condition_variable _idleCondition;
+	std::vector<std::unique_ptr<Worker>> _workers;
+	std::vector<std::thread> _threads;
+	std::deque<RolloutJob> _unassignedJobs;		// Jobs waiting for any live instance
+	size_t _pendingJobs = 0;
+	unsigned long long _nextJobId = 1;
+	std::atomic<bool> _isStopping{ false };
+};
@@ -0,0 +1,95 @@
+#include "SharedPayloadBuffer.h"
+
+#include <codecvt>
+#include <cstring>
+#include <iostream>
+#include <locale>
+#include <new>
+#include "windows.h"
+
+SharedPayloadBuffer::SharedPayloadBuffer(const std::string& mappingName, const unsigned char* data, size_t size) : _name(mappingName)
+{
+    map(sizeof(SharedPayloadHeader) + size, true);
+
+    if (_base)
+    {
+        _header = new (_base) SharedPayloadHeader();
+        _header->_size = size;
+
+        if (size > 0)
+        {
+            std::memcpy(_base + sizeof(SharedPayloadHeader), data, size);
+        }
+    }
+}
+
+SharedPayloadBuffer::SharedPayloadBuffer(const std::string& mappingName) : _name(mappingName)
+{
+    map(0, false);
+
+    if (_base)
+    {
+        _header = reinterpret_cast<SharedPayloadHeader*>(_base);
+
+        if (_header->_magic != SharedPayloadHeader::MagicValue || _header->_version != SharedPayloadHeader::CurrentVersion)
+        {
+            std::cout << "Error: Shared payload mapping has an unexpected layout" << std::endl;
+            _header = nullptr;
+        }
+    }
+}
+
+SharedPayloadBuffer::~SharedPayloadBuffer()
+{
+    if (_base)
+    {
+        ::UnmapViewOfFile(_base);
+    }
+
+    if (_mapping)
+    {
+        ::CloseHandle(_mapping);
+    }
+}
+
+std::string SharedPayloadBuffer::getMappingName(const std::string& uniqueChannelId, const std::string& payloadName)
+{
+    return "Local\\dol-payload-" + uniqueChannelId + "-" + payloadName;
+}
+
+const unsigned char* SharedPayloadBuffer::getData() const
+{
+    return _header ? _base + sizeof(SharedPayloadHeader) : nullptr;
+}
+
+size_t SharedPayloadBuffer::getSize() const
+{
+    return _header ? size_t(_header->_size) : 0;
+}
+
+void SharedPayloadBuffer::map(size_t size, bool isOwner)
+{
+    std::wstring mappingName = std::wstring_convert<std::codecvt_utf8<wchar_t>>().from_bytes(_name);
+
+    if (isOwner)
+    {
+        _mapping = ::CreateFileMapping(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, DWORD(static_cast<unsigned long long>(size) >> 32), DWORD(size), mappingName.c_str());
+    }
+    else
+    {
+        _mapping = ::OpenFileMapping(FILE_MAP_READ, FALSE, mappingName.c_str());
+    }
+
+    if (!_mapping)
+    {
+        std::cout << "Error: Could not open shared payload mapping: " << GetLastError() << std::endl;
+        return;
+    }
+
+    _base = static_cast<unsigned char*>(::MapViewOfFile(_mapping, isOwner ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0));
+
+    if (!_base)
+    {
+        std::cout << "Error: Could not map shared payload view: " << GetLastError() << std::endl;
+    }
+}
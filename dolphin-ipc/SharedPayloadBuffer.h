@@ -0,0 +1,45 @@
+#pragma once
+// Hands a large payload (save states, memory card images) to another process through named shared memory, instead of
+// serializing it through the pipe. The creator keeps the mapping alive until the receiver has had a chance to copy it out.
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN             // Exclude rarely-used stuff from Windows headers
+#endif // !WIN32_LEAN_AND_MEAN
+
+#include <cstddef>
+#include <string>
+
+struct SharedPayloadHeader
+{
+	static constexpr unsigned int MagicValue = 0x44415950; // 'PYAD'
+	static constexpr unsigned int CurrentVersion = 1;
+
+	unsigned int _magic = MagicValue;
+	unsigned int _version = CurrentVersion;
+	unsigned long long _size = 0;
+};
+
+class SharedPayloadBuffer
+{
+public:
+	// Creator side, creates a mapping holding a copy of the payload
+	SharedPayloadBuffer(const std::string& mappingName, const unsigned char* data, size_t size);
+	// Receiver side, opens an existing mapping read-only
+	SharedPayloadBuffer(const std::string& mappingName);
+	~SharedPayloadBuffer();
+
+	static std::string getMappingName(const std::string& uniqueChannelId, const std::string& payloadName);
+
+	bool isValid() const { return _header != nullptr; }
+	const std::string& getName() const { return _name; }
+	const unsigned char* getData() const;
+	size_t getSize() const;
+
+private:
+	void map(size_t size, bool isOwner);
+
+	std::string _name;
+	void* _mapping = nullptr;
+	SharedPayloadHeader* _header = nullptr;
+	unsigned char* _base = nullptr;
+};
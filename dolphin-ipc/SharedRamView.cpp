@@ -0,0 +1,264 @@
+#include "SharedRamView.h"
+
+#include <codecvt>
+#include <cstring>
+#include <iostream>
+#include <locale>
+#include <new>
+#include "windows.h"
+
+SharedRamView::SharedRamView(const std::string& uniqueChannelId, unsigned char* mem1, unsigned int mem1Size, unsigned long long mem1ArenaOffset,
+    unsigned char* mem2, unsigned int mem2Size, unsigned long long mem2ArenaOffset)
+{
+    const std::string arenaMappingName = getArenaMappingName();
+
+    if (!mem1 || arenaMappingName.size() >= sizeof(SharedRamHeader::_arenaMappingName) || !mapArena(arenaMappingName))
+    {
+        return;
+    }
+
+    const unsigned char* mappedMem1 = getArenaRange(mem1ArenaOffset, mem1Size);
+    const unsigned char* mappedMem2 = mem2 ? getArenaRange(mem2ArenaOffset, mem2Size) : nullptr;
+
+    // A wrong offset would hand readers some other region, so each one is checked to really alias the live memory
+    if (!isSameMemory(mem1, mappedMem1) || (mem2 && !isSameMemory(mem2, mappedMem2)))
+    {
+        std::cout << "Error: Emulated memory mapping does not have the expected layout" << std::endl;
+        return;
+    }
+
+    mapHeader(uniqueChannelId, true);
+
+    if (_header)
+    {
+        _header = new (_header) SharedRamHeader();
+        _header->_mem1Size = mem1Size;
+        _header->_mem2Size = mem2 ? mem2Size : 0;
+        _header->_mem1ArenaOffset = mem1ArenaOffset;
+        _header->_mem2ArenaOffset = mem2 ? mem2ArenaOffset : 0;
+        std::memcpy(_header->_arenaMappingName, arenaMappingName.c_str(), arenaMappingName.size() + 1);
+
+        _mem1 = mappedMem1;
+        _mem2 = mappedMem2;
+    }
+}
+
+SharedRamView::SharedRamView(const std::string& uniqueChannelId)
+{
+    mapHeader(uniqueChannelId, false);
+
+    if (!_header)
+    {
+        return;
+    }
+
+    if (_header->_magic != SharedRamHeader::MagicValue || _header->_version != SharedRamHeader::CurrentVersion)
+    {
+        std::cout << "Error: Shared RAM mapping has an unexpected layout" << std::endl;
+        _header = nullptr;
+        return;
+    }
+
+    std::string arenaMappingName(_header->_arenaMappingName, strnlen(_header->_arenaMappingName, sizeof(_header->_arenaMappingName)));
+
+    if (mapArena(arenaMappingName))
+    {
+        _mem1 = getArenaRange(_header->_mem1ArenaOffset, _header->_mem1Size);
+        _mem2 = _header->_mem2Size > 0 ? getArenaRange(_header->_mem2ArenaOffset, _header->_mem2Size) : nullptr;
+    }
+}
+
+SharedRamView::~SharedRamView()
+{
+    if (_arenaBase)
+    {
+        ::UnmapViewOfFile(_arenaBase);
+    }
+
+    if (_arenaMapping)
+    {
+        ::CloseHandle(_arenaMapping);
+    }
+
+    if (_header)
+    {
+        ::UnmapViewOfFile(_header);
+    }
+
+    if (_headerMapping)
+    {
+        ::CloseHandle(_headerMapping);
+    }
+}
+
+std::string SharedRamView::getMappingName(const std::string& uniqueChannelId)
+{
+    return "Local\\dol-ram-" + uniqueChannelId;
+}
+
+std::string SharedRamView::getArenaMappingName()
+{
+    // Matches Common::MemArena::GrabSHMSegment
+    return "dolphin-emu." + std::to_string(::GetCurrentProcessId());
+}
+
+void SharedRamView::mapHeader(const std::string& uniqueChannelId, bool isOwner)
+{
+    _isOwner = isOwner;
+
+    std::wstring mappingName = std::wstring_convert<std::codecvt_utf8<wchar_t>>().from_bytes(getMappingName(uniqueChannelId));
+
+    if (_isOwner)
+    {
+        _headerMapping = ::CreateFileMapping(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, DWORD(sizeof(SharedRamHeader)), mappingName.c_str());
+    }
+    else
+    {
+        _headerMapping = ::OpenFileMapping(FILE_MAP_READ, FALSE, mappingName.c_str());
+    }
+
+    if (!_headerMapping)
+    {
+        std::cout << "Error: Could not create shared RAM mapping: " << GetLastError() << std::endl;
+        return;
+    }
+
+    _header = static_cast<SharedRamHeader*>(::MapViewOfFile(_headerMapping, _isOwner ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0));
+
+    if (!_header)
+    {
+        std::cout << "Error: Could not map shared RAM view: " << GetLastError() << std::endl;
+    }
+}
+
+bool SharedRamView::mapArena(const std::string& arenaMappingName)
+{
+    std::wstring mappingName = std::wstring_convert<std::codecvt_utf8<wchar_t>>().from_bytes(arenaMappingName);
+
+    // Both sides only ever get a read-only view, so the server can not corrupt emulated RAM
+    _arenaMapping = ::OpenFileMapping(FILE_MAP_READ, FALSE, mappingName.c_str());
+
+    if (!_arenaMapping)
+    {
+        std::cout << "Error: Could not open emulated memory mapping: " << GetLastError() << std::endl;
+        return false;
+    }
+
+    _arenaBase = static_cast<unsigned char*>(::MapViewOfFile(_arenaMapping, FILE_MAP_READ, 0, 0, 0));
+
+    MEMORY_BASIC_INFORMATION info = {};
+
+    if (!_arenaBase || !::VirtualQuery(_arenaBase, &info, sizeof(info)))
+    {
+        std::cout << "Error: Could not map emulated memory view: " << GetLastError() << std::endl;
+        return false;
+    }
+
+    _arenaSize = info.RegionSize;
+
+    return true;
+}
+
+const unsigned char* SharedRamView::getArenaRange(unsigned long long offset, size_t size) const
+{
+    if (!_arenaBase || offset > _arenaSize || size > _arenaSize - offset)
+    {
+        return nullptr;
+    }
+
+    return _arenaBase + offset;
+}
+
+// Called with the CPU paused, so flipping a byte for a moment is not observed by the game
+bool SharedRamView::isSameMemory(unsigned char* live, const unsigned char* mapped)
+{
+    if (!live || !mapped)
+    {
+        return false;
+    }
+
+    const unsigned char original = live[0];
+    live[0] = (unsigned char)~original;
+    const bool isSame = *static_cast<const volatile unsigned char*>(mapped) == (unsigned char)~original;
+    live[0] = original;
+
+    return isSame;
+}
+
+void SharedRamView::publish(unsigned long long frameNumber)
+{
+    if (!_header || !_isOwner)
+    {
+        return;
+    }
+
+    // Both the CPU and host threads publish, so the sequence only ever moves forward in whole steps
+    _header->_frameNumber.store(frameNumber, std::memory_order_relaxed);
+    _header->_sequence.fetch_add(2, std::memory_order_release);
+}
+
+bool SharedRamView::read(unsigned int address, void* outBuffer, size_t size, unsigned long long* outFrameNumber) const
+{
+    const unsigned char* pointer = getPointerForRange(address, size);
+
+    if (!pointer)
+    {
+        return false;
+    }
+
+    while (true)
+    {
+        unsigned long long sequence = beginRead();
+        std::memcpy(outBuffer, pointer, size);
+        unsigned long long frameNumber = _header->_frameNumber.load(std::memory_order_relaxed);
+
+        if (endRead(sequence))
+        {
+            if (outFrameNumber)
+            {
+                *outFrameNumber = frameNumber;
+            }
+
+            return true;
+        }
+    }
+}
+
+unsigned long long SharedRamView::beginRead() const
+{
+    return _header->_sequence.load(std::memory_order_acquire);
+}
+
+bool SharedRamView::endRead(unsigned long long sequence) const
+{
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return _header->_sequence.load(std::memory_order_relaxed) == sequence;
+}
+
+// Same address translation as the instance uses for emulated memory reads
+const unsigned char* SharedRamView::getPointerForRange(unsigned int address, size_t size) const
+{
+    if (!_header || size == 0)
+    {
+        return nullptr;
+    }
+
+    address &= 0x3FFFFFFF;
+
+    if (_mem1 && address < _header->_mem1Size && size <= _header->_mem1Size - address)
+    {
+        return _mem1 + address;
+    }
+
+    if ((address >> 28) == 0x1)
+    {
+        address &= 0x0FFFFFFF;
+
+        if (_mem2 && address < _header->_mem2Size && size <= _header->_mem2Size - address)
+        {
+            return _mem2 + address;
+        }
+    }
+
+    return nullptr;
+}
@@ -0,0 +1,76 @@
+#pragma once
+// Read-only view of an instance's emulated RAM, so that bulk reads need no IPC. Dolphin already keeps emulated memory in a
+// named file mapping (Common::MemArena), which readers map directly, so nothing is copied. A small header mapping carries
+// the layout and a seqlock style sequence, bumped at every published frame boundary.
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN             // Exclude rarely-used stuff from Windows headers
+#endif // !WIN32_LEAN_AND_MEAN
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+
+struct SharedRamHeader
+{
+	static constexpr unsigned int MagicValue = 0x4D415244; // 'DRAM'
+	static constexpr unsigned int CurrentVersion = 2;
+
+	unsigned int _magic = MagicValue;
+	unsigned int _version = CurrentVersion;
+	std::atomic<unsigned long long> _sequence{ 0 };
+	std::atomic<unsigned long long> _frameNumber{ 0 };
+	unsigned int _mem1Size = 0;
+	unsigned int _mem2Size = 0;
+	unsigned long long _mem1ArenaOffset = 0;	// Where each region lives in Dolphin's emulated memory mapping
+	unsigned long long _mem2ArenaOffset = 0;
+	char _arenaMappingName[64] = {};
+};
+
+class SharedRamView
+{
+public:
+	// Instance side, with the CPU paused. Publishes where MEM1 and MEM2 live in Dolphin's own emulated memory mapping, after
+	// checking the offsets against the live pointers. mem2 is null on GameCube.
+	SharedRamView(const std::string& uniqueChannelId, unsigned char* mem1, unsigned int mem1Size, unsigned long long mem1ArenaOffset,
+		unsigned char* mem2, unsigned int mem2Size, unsigned long long mem2ArenaOffset);
+	// Server side, opens both mappings read-only
+	SharedRamView(const std::string& uniqueChannelId);
+	~SharedRamView();
+
+	static std::string getMappingName(const std::string& uniqueChannelId);
+	// The name Dolphin's MemArena gives the mapping that backs emulated memory in the calling process
+	static std::string getArenaMappingName();
+
+	bool isValid() const { return _header != nullptr && _mem1 != nullptr; }
+
+	// Marks a frame boundary. Nothing is copied, readers see emulated RAM live.
+	void publish(unsigned long long frameNumber);
+
+	// Copies a range of emulated RAM by emulated address, retrying if a frame boundary passed meanwhile
+	bool read(unsigned int address, void* outBuffer, size_t size, unsigned long long* outFrameNumber = nullptr) const;
+
+	// For bulk analytics directly on the mapping. Reads did not straddle a frame boundary if endRead returns true for the value
+	// beginRead returned. Only reads made while emulation is paused are guaranteed not to see a frame in progress.
+	unsigned long long beginRead() const;
+	bool endRead(unsigned long long sequence) const;
+	const unsigned char* getMem1() const { return _mem1; }
+	const unsigned char* getMem2() const { return _mem2; }
+	const SharedRamHeader* getHeader() const { return _header; }
+
+private:
+	void mapHeader(const std::string& uniqueChannelId, bool isOwner);
+	bool mapArena(const std::string& arenaMappingName);
+	const unsigned char* getArenaRange(unsigned long long offset, size_t size) const;
+	static bool isSameMemory(unsigned char* live, const unsigned char* mapped);
+	const unsigned char* getPointerForRange(unsigned int address, size_t size) const;
+
+	void* _headerMapping = nullptr;
+	SharedRamHeader* _header = nullptr;
+	void* _arenaMapping = nullptr;
+	unsigned char* _arenaBase = nullptr;
+	size_t _arenaSize = 0;
+	const unsigned char* _mem1 = nullptr;
+	const unsigned char* _mem2 = nullptr;
+	bool _isOwner = false;
+};
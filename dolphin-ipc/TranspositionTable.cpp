@@ -0,0 +1,68 @@
+#include "TranspositionTable.h"
+
+bool TranspositionTable::tryVisit(unsigned long long stateHash, const Entry& entry, Entry* outExisting)
+{
+    Shard& shard = getShard(stateHash);
+    std::lock_guard<std::mutex> lock(shard._mutex);
+
+    auto inserted = shard._entries.emplace(stateHash, entry);
+
+    if (inserted.second)
+    {
+        return true;
+    }
+
+    Entry& existing = inserted.first->second;
+
+    if (entry._depth < existing._depth)
+    {
+        existing = entry;
+        return true;
+    }
+
+    if (outExisting)
+    {
+        *outExisting = existing;
+    }
+
+    return false;
+}
+
+bool TranspositionTable::find(unsigned long long stateHash, Entry& outEntry)
+{
+    Shard& shard = getShard(stateHash);
+    std::lock_guard<std::mutex> lock(shard._mutex);
+
+    auto found = shard._entries.find(stateHash);
+
+    if (found == shard._entries.end())
+    {
+        return false;
+    }
+
+    outEntry = found->second;
+
+    return true;
+}
+
+size_t TranspositionTable::size()
+{
+    size_t total = 0;
+
+    for (Shard& shard : _shards)
+    {
+        std::lock_guard<std::mutex> lock(shard._mutex);
+        total += shard._entries.size();
+    }
+
+    return total;
+}
+
+void TranspositionTable::clear()
+{
+    for (Shard& shard : _shards)
+    {
+        std::lock_guard<std::mutex> lock(shard._mutex);
+        shard._entries.clear();
+    }
+}
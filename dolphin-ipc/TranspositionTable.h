@@ -0,0 +1,45 @@
+#pragma once
+// Concurrent table of visited game states, keyed by the canonical state hash an instance reports after ConfigureStateHash.
+// Search code checks a state here before expanding it, so input sequences that converge on the same state are only explored
+// once. The table is split into independently locked shards so rollout workers rarely wait on each other.
+
+#include <array>
+#include <mutex>
+#include <unordered_map>
+
+class TranspositionTable
+{
+public:
+	struct Entry
+	{
+		unsigned long long _value = 0;		// Caller defined, for example the job or node that first reached the state
+		int _depth = 0;						// Distance from the search root, a shallower visit replaces a deeper one
+	};
+
+	// Returns true if the state is new or was only reached deeper, and records this visit. Otherwise leaves the table as is
+	// and, if given, fills outExisting with the earlier visit.
+	bool tryVisit(unsigned long long stateHash, const Entry& entry, Entry* outExisting = nullptr);
+	bool find(unsigned long long stateHash, Entry& outEntry);
+	size_t size();
+	void clear();
+
+private:
+	static constexpr size_t ShardCount = 64;
+
+	// State hashes are already uniformly distributed, hashing them again would only cost time
+	struct IdentityHash
+	{
+		size_t operator()(unsigned long long stateHash) const { return size_t(stateHash); }
+	};
+
+	struct Shard
+	{
+		std::mutex _mutex;
+		std::unordered_map<unsigned long long, Entry, IdentityHash> _entries;
+	};
+
+	// High bits pick the shard, so the low bits the maps bucket by stay independent of it
+	Shard& getShard(unsigned long long stateHash) { return _shards[stateHash >> 58]; }
+
+	std::array<Shard, ShardCount> _shards;
+};